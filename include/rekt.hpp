@@ -8,6 +8,21 @@
 #include <rekt/introspection.hpp>
 #include <rekt/record.hpp>
 #include <rekt/record_traits.hpp>
+#include <rekt/packed_record.hpp>
+#include <rekt/bits.hpp>
 #include <rekt/symbols_macro.hpp>
 #include <rekt/utility.hpp>
-#include <rekt/iterator.hpp>
\ No newline at end of file
+#include <rekt/iterator.hpp>
+#include <rekt/columns.hpp>
+#include <rekt/split_record.hpp>
+#include <rekt/sort.hpp>
+#include <rekt/external_sort.hpp>
+#include <rekt/parallel.hpp>
+#include <rekt/simd.hpp>
+#include <rekt/join.hpp>
+#include <rekt/group_by.hpp>
+#include <rekt/query.hpp>
+#include <rekt/expression.hpp>
+#include <rekt/selection.hpp>
+#include <rekt/hash.hpp>
+#include <rekt/distinct.hpp>
\ No newline at end of file
@@ -0,0 +1,148 @@
+/// Copyright (c) Benjamin Kietzman (github.com/bkietz)
+///
+/// Distributed under the Boost Software License, Version 1.0. (See accompanying
+/// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace rekt
+{
+namespace
+{
+
+///
+/// A fixed number of bits, packed 64 to a word. Bit i is bit (i % 64)
+/// of word (i / 64); bits of the last word past size() are always 0.
+class bitmap
+{
+public:
+  using word_type = std::uint64_t;
+  static constexpr std::size_t word_bits = 64;
+
+  bitmap() = default;
+
+  explicit bitmap(std::size_t size)
+      : words_(words_for(size)), size_{ size }
+  {
+  }
+
+  static constexpr std::size_t words_for(std::size_t bits)
+  {
+    return (bits + word_bits - 1) / word_bits;
+  }
+
+  std::size_t size() const
+  {
+    return size_;
+  }
+
+  bool test(std::size_t i) const
+  {
+    return (words_[i / word_bits] >> (i % word_bits)) & 1;
+  }
+
+  void set(std::size_t i, bool value = true)
+  {
+    auto &w = words_[i / word_bits];
+    auto mask = word_type(1) << (i % word_bits);
+    w = value ? (w | mask) : (w & ~mask);
+  }
+
+  ///
+  /// number of bits which are set
+  std::size_t count() const
+  {
+    std::size_t n = 0;
+    for (auto w : words_)
+    {
+      n += popcount(w);
+    }
+    return n;
+  }
+
+  ///
+  /// a word whose bit b is flags[b], given word_bits flags which are each 0 or 1
+  static word_type pack(unsigned char const *flags)
+  {
+    word_type w = 0;
+    for (std::size_t byte = 0; byte != sizeof(word_type); ++byte)
+    {
+      std::uint64_t eight;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+      eight = 0;
+      for (std::size_t k = 0; k != 8; ++k)
+      {
+        eight |= std::uint64_t(flags[byte * 8 + k]) << (k * 8);
+      }
+#else
+      std::memcpy(&eight, flags + byte * 8, 8);
+#endif
+      // multiplying gathers the low bit of each of the 8 bytes into the top byte
+      w |= word_type((eight * 0x0102040810204080ULL) >> 56) << (byte * 8);
+    }
+    return w;
+  }
+
+  ///
+  /// the position of the lowest set bit of a nonzero word
+  static std::size_t lowest_set(word_type w)
+  {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<std::size_t>(__builtin_ctzll(w));
+#else
+    std::size_t n = 0;
+    for (; (w & 1) == 0; w >>= 1)
+    {
+      ++n;
+    }
+    return n;
+#endif
+  }
+
+  static std::size_t popcount(word_type w)
+  {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<std::size_t>(__builtin_popcountll(w));
+#else
+    std::size_t n = 0;
+    for (; w != 0; w &= w - 1)
+    {
+      ++n;
+    }
+    return n;
+#endif
+  }
+
+  word_type *words()
+  {
+    return words_.data();
+  }
+
+  word_type const *words() const
+  {
+    return words_.data();
+  }
+
+  friend bool operator==(bitmap const &l, bitmap const &r)
+  {
+    return l.size_ == r.size_ && l.words_ == r.words_;
+  }
+
+  friend bool operator!=(bitmap const &l, bitmap const &r)
+  {
+    return !(l == r);
+  }
+
+private:
+  std::vector<word_type> words_;
+  std::size_t size_ = 0;
+};
+
+constexpr std::size_t bitmap::word_bits;
+
+} // namespace
+} // namespace rekt
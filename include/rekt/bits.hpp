@@ -0,0 +1,398 @@
+/// Copyright (c) Benjamin Kietzman (github.com/bkietz)
+///
+/// Distributed under the Boost Software License, Version 1.0. (See accompanying
+/// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <rekt/introspection.hpp>
+#include <rekt/record.hpp>
+#include <tuple>
+
+namespace rekt
+{
+namespace
+{
+
+///
+/// An unsigned integer of N bits (at most 64). Values are masked to N bits
+/// on construction. On its own, bits<N> takes the smallest unsigned integer
+/// type which holds N bits; in a bit_packed_record it takes N bits.
+template <std::size_t N>
+class bits
+{
+  static_assert(N >= 1 && N <= 64, "bits<N> holds from 1 to 64 bits");
+
+public:
+  using value_type = std::conditional_t<N <= 8, std::uint8_t,
+                                        std::conditional_t<N <= 16, std::uint16_t,
+                                                           std::conditional_t<N <= 32, std::uint32_t, std::uint64_t>>>;
+
+  static constexpr value_type mask = static_cast<value_type>(N == 64 ? ~std::uint64_t(0) : (std::uint64_t(1) << N) - 1);
+
+  constexpr bits(value_type v = 0)
+      : value_(v & mask)
+  {
+  }
+
+  constexpr operator value_type() const
+  {
+    return value_;
+  }
+
+private:
+  value_type value_;
+};
+
+template <std::size_t N>
+constexpr typename bits<N>::value_type bits<N>::mask;
+
+///
+/// Bits a field takes in a bit_packed_record, or 0 if it isn't packed
+template <typename Value>
+struct bit_width : index_constant<0>
+{
+};
+
+template <>
+struct bit_width<bool> : index_constant<1>
+{
+};
+
+template <std::size_t N>
+struct bit_width<bits<N>> : index_constant<N>
+{
+};
+
+///
+/// Where a bit_packed_record keeps each field. Packed fields are laid out
+/// in declaration order, each in the lowest bits left in the current word
+/// or at the start of the next if they don't fit, so none straddles words.
+template <typename... Values>
+struct bit_layout
+{
+  static constexpr std::size_t word_bits = 64;
+  // with a trailing 0, so that an empty record has a valid array
+  static constexpr std::size_t widths[] = { bit_width<Values>::value..., 0 };
+
+  ///
+  /// first bit of field i, counting from bit 0 of word 0;
+  /// for i == sizeof...(Values), the number of bits used
+  static constexpr std::size_t offset_of(std::size_t i)
+  {
+    std::size_t offset = 0;
+    for (std::size_t j = 0; j != i + 1; ++j)
+    {
+      if (widths[j] != 0 && offset % word_bits + widths[j] > word_bits)
+      {
+        offset += word_bits - offset % word_bits;
+      }
+      if (j != i)
+      {
+        offset += widths[j];
+      }
+    }
+    return offset;
+  }
+
+  static constexpr std::size_t words = (offset_of(sizeof...(Values)) + word_bits - 1) / word_bits;
+
+  static constexpr std::size_t unpacked()
+  {
+    std::size_t n = 0;
+    for (std::size_t i = 0; i != sizeof...(Values); ++i)
+    {
+      n += widths[i] == 0;
+    }
+    return n;
+  }
+
+  ///
+  /// the declaration index of the unpacked field at position p among them
+  static constexpr std::size_t unpacked_at(std::size_t p)
+  {
+    std::size_t i = 0;
+    for (;; ++i)
+    {
+      if (widths[i] == 0 && p-- == 0)
+      {
+        return i;
+      }
+    }
+  }
+};
+
+template <typename... Values>
+constexpr std::size_t bit_layout<Values...>::widths[];
+
+template <typename... Values>
+constexpr std::size_t bit_layout<Values...>::words;
+
+template <typename Layout, std::size_t... P>
+index_sequence<Layout::unpacked_at(P)...> unpacked_order(index_sequence<P...>);
+
+template <typename Reference, typename Value>
+struct bit_reference_conversions
+{
+};
+
+// a reference to bits<N> also converts straight to an integer,
+// so that it compares and does arithmetic like a bits<N> would
+template <typename Reference, std::size_t N>
+struct bit_reference_conversions<Reference, bits<N>>
+{
+  operator typename bits<N>::value_type() const
+  {
+    return static_cast<Reference const &>(*this).operator bits<N>();
+  }
+};
+
+///
+/// A reference to a field of Width bits at Offset in a word
+template <typename Value, std::size_t Offset, std::size_t Width>
+class bit_reference
+    : public bit_reference_conversions<bit_reference<Value, Offset, Width>, Value>
+{
+public:
+  static constexpr std::uint64_t mask = Width == 64 ? ~std::uint64_t(0) : (std::uint64_t(1) << Width) - 1;
+
+  explicit bit_reference(std::uint64_t &word)
+      : word_(word)
+  {
+  }
+
+  bit_reference(bit_reference const &) = default;
+
+  operator Value() const
+  {
+    return static_cast<Value>((word_ >> Offset) & mask);
+  }
+
+  bit_reference &operator=(Value v)
+  {
+    word_ = (word_ & ~(mask << Offset)) | ((static_cast<std::uint64_t>(v) & mask) << Offset);
+    return *this;
+  }
+
+  // assigns the referenced value, like a reference would
+  bit_reference &operator=(bit_reference const &other)
+  {
+    return *this = static_cast<Value>(other);
+  }
+
+private:
+  std::uint64_t &word_;
+};
+
+template <typename Symbol, typename... Symbols>
+constexpr std::size_t index_of_symbol()
+{
+  bool const same[] = { std::is_same<Symbol, Symbols>::value..., false };
+  std::size_t i = 0;
+  while (i != sizeof...(Symbols) && !same[i])
+  {
+    ++i;
+  }
+  return i;
+}
+
+template <typename Fields, typename Indices>
+struct unpacked_record;
+
+template <typename... Fields, std::size_t... I>
+struct unpacked_record<type_sequence<Fields...>, index_sequence<I...>>
+{
+  using type = record<std::tuple_element_t<I, std::tuple<Fields...>>...>;
+};
+
+template <typename... Fields>
+class bit_packed_record;
+
+///
+/// A record whose bool and bits<N> fields share 64 bit words rather than
+/// taking a byte (or more) each. Other fields are stored as in a record:
+///
+///     auto flags = make_bit_packed_record(beta = true, dark_mode = false, tier = bits<3>{ 5 }, name = "x"s);
+///     beta(flags) = false; // a bit_reference
+///
+/// get() for a packed field returns a bit_reference proxy (or the value,
+/// for const and rvalue records); get() for other fields returns what a
+/// record's would. Constructors, field_enum and map() use declaration order.
+/// Records of 30 bools take one word instead of 30 bytes.
+///
+/// The storage<Value, IsEmpty> of a field can't share a word with its
+/// neighbors, so packing is a property of the whole record rather than a
+/// storage specialization; a bits<N> in an ordinary record takes the
+/// smallest integer which holds it.
+template <typename... Symbols, typename... Values>
+class bit_packed_record<field<Symbols, Values>...>
+    : private storage<typename unpacked_record<type_sequence<field<Symbols, Values>...>,
+                                               decltype(unpacked_order<bit_layout<Values...>>(make_index_sequence<bit_layout<Values...>::unpacked()>{}))>::type,
+                      bit_layout<Values...>::unpacked() == 0>
+{
+  using layout = bit_layout<Values...>;
+  using unpacked_indices = decltype(unpacked_order<layout>(make_index_sequence<layout::unpacked()>{}));
+
+  template <std::size_t I>
+  using value_at = std::tuple_element_t<I, std::tuple<Values...>>;
+
+  template <typename Symbol>
+  using index_for = index_constant<index_of_symbol<Symbol, Symbols...>()>;
+
+  template <typename Symbol>
+  using enable_if_packed = std::enable_if_t<(index_for<Symbol>::value < sizeof...(Symbols)) &&
+                                            bit_width<value_at<index_for<Symbol>::value % sizeof...(Symbols)>>::value != 0>;
+
+  template <typename Symbol>
+  using enable_if_unpacked = std::enable_if_t<(index_for<Symbol>::value < sizeof...(Symbols)) &&
+                                              bit_width<value_at<index_for<Symbol>::value % sizeof...(Symbols)>>::value == 0>;
+
+  template <std::size_t I>
+  using reference_at = bit_reference<value_at<I>, layout::offset_of(I) % layout::word_bits, bit_width<value_at<I>>::value>;
+
+public:
+  using unpacked_type = typename unpacked_record<type_sequence<field<Symbols, Values>...>, unpacked_indices>::type;
+
+  bit_packed_record() = default;
+
+  bit_packed_record(Values... args)
+      : bit_packed_record(std::forward_as_tuple(static_cast<Values &&>(args)...), unpacked_indices{}, index_sequence_for<Values...>{})
+  {
+  }
+
+  bit_packed_record(field<Symbols, Values>... fields)
+      : bit_packed_record(std::forward_as_tuple(static_cast<Values &&>(fields.value())...), unpacked_indices{}, index_sequence_for<Values...>{})
+  {
+  }
+
+  template <typename Symbol, typename = enable_if_packed<Symbol>>
+  friend reference_at<index_for<Symbol>::value> get(Symbol const &, bit_packed_record &r)
+  {
+    return r.reference_<index_for<Symbol>::value>();
+  }
+
+  template <typename Symbol, typename = enable_if_packed<Symbol>>
+  friend value_at<index_for<Symbol>::value> get(Symbol const &, bit_packed_record const &r)
+  {
+    return const_cast<bit_packed_record &>(r).template reference_<index_for<Symbol>::value>();
+  }
+
+  template <typename Symbol, typename = enable_if_packed<Symbol>>
+  friend value_at<index_for<Symbol>::value> get(Symbol const &s, bit_packed_record &&r)
+  {
+    return get(s, static_cast<bit_packed_record const &>(r));
+  }
+
+  template <typename Symbol, typename = enable_if_unpacked<Symbol>>
+  friend decltype(auto) get(Symbol const &s, bit_packed_record &r)
+  {
+    return get(s, r.unpacked_());
+  }
+
+  template <typename Symbol, typename = enable_if_unpacked<Symbol>>
+  friend decltype(auto) get(Symbol const &s, bit_packed_record const &r)
+  {
+    return get(s, r.unpacked_());
+  }
+
+  template <typename Symbol, typename = enable_if_unpacked<Symbol>>
+  friend decltype(auto) get(Symbol const &s, bit_packed_record &&r)
+  {
+    return get(s, std::move(r.unpacked_()));
+  }
+
+  ///
+  /// the words holding the packed fields
+  std::array<std::uint64_t, layout::words> const &words() const
+  {
+    return words_;
+  }
+
+  friend bool operator==(bit_packed_record const &l, bit_packed_record const &r)
+  {
+    return l.words_ == r.words_ && l.unpacked_() == r.unpacked_();
+  }
+
+  friend bool operator!=(bit_packed_record const &l, bit_packed_record const &r)
+  {
+    return !(l == r);
+  }
+
+private:
+  // fields which aren't packed are kept in a record, through the same
+  // storage as a field's value so that it takes no room when empty
+  using unpacked_storage = storage<unpacked_type, layout::unpacked() == 0>;
+
+  template <typename Tuple, std::size_t... U, std::size_t... I>
+  bit_packed_record(Tuple &&values, index_sequence<U...>, index_sequence<I...>)
+      : unpacked_storage{ unpacked_type{ static_cast<value_at<U> &&>(std::get<U>(values))... } }
+  {
+    (void)std::initializer_list<int>{ (set_(index_c<I>, std::get<I>(values)), 0)... };
+  }
+
+  template <std::size_t I>
+  reference_at<I> reference_()
+  {
+    return reference_at<I>{ words_[layout::offset_of(I) / layout::word_bits] };
+  }
+
+  template <std::size_t I, typename Value>
+  void set_(index_constant<I>, Value const &v)
+  {
+    set_(index_c<I>, v, integer_c<bool, bit_width<value_at<I>>::value != 0>);
+  }
+
+  template <std::size_t I, typename Value>
+  void set_(index_constant<I>, Value const &v, std::true_type /* packed */)
+  {
+    reference_<I>() = v;
+  }
+
+  template <std::size_t I, typename Value>
+  void set_(index_constant<I>, Value const &, std::false_type /* packed */)
+  {
+  }
+
+  unpacked_type &unpacked_()
+  {
+    return unpacked_storage::value();
+  }
+
+  unpacked_type const &unpacked_() const
+  {
+    return unpacked_storage::value();
+  }
+
+  std::array<std::uint64_t, layout::words> words_ = {};
+};
+
+///
+/// Like make_record, but bit packed; field values are decayed
+template <typename... Symbol, typename... Value>
+auto make_bit_packed_record(field<Symbol, Value> &&... fields)
+{
+  return bit_packed_record<field<Symbol, std::decay_t<Value>>...>{ fields.value()... };
+}
+
+template <typename... Symbol, typename... Value>
+constexpr auto get(struct field_enum const &, bit_packed_record<field<Symbol, Value>...> const &)
+{
+  return field_enum.make(symbol_set<Symbol...>{}, index_sequence_for<Symbol...>{});
+}
+
+template <typename... Symbol, typename... Value, typename Function>
+auto map(bit_packed_record<field<Symbol, Value>...> &rec, Function &&f)
+{
+  return map(rec, std::forward<Function>(f), symbol_set<Symbol...>{});
+}
+
+template <typename... Symbol, typename... Value, typename Function>
+auto map(bit_packed_record<field<Symbol, Value>...> const &rec, Function &&f)
+{
+  return map(rec, std::forward<Function>(f), symbol_set<Symbol...>{});
+}
+
+} // namespace
+} // namespace rekt
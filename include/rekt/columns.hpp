@@ -0,0 +1,311 @@
+/// Copyright (c) Benjamin Kietzman (github.com/bkietz)
+///
+/// Distributed under the Boost Software License, Version 1.0. (See accompanying
+/// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <rekt/iterator.hpp>
+#include <tuple>
+#include <vector>
+
+namespace rekt
+{
+namespace
+{
+
+///
+/// Whether get(Symbol{}, it) gives an iterator over a column, as for a
+/// zip::iterator
+template <typename Symbol, typename Iterator, typename = void>
+struct has_column_iterator : std::false_type
+{
+};
+
+template <typename Symbol, typename Iterator>
+struct has_column_iterator<
+    Symbol, Iterator,
+    std::enable_if_t<std::is_convertible<
+        typename std::iterator_traits<decltype(get(Symbol{}, std::declval<Iterator const &>()))>::iterator_category,
+        std::forward_iterator_tag>::value>> : std::true_type
+{
+};
+
+///
+/// columns stores a sequence of records with one contiguous buffer
+/// per symbol (a struct of arrays) rather than one buffer of records.
+/// Loops which touch only a couple of fields don't drag the rest
+/// through the cache.
+///
+/// The buffers are exposed as fields of the columns object itself:
+///
+///     columns<record<field<price_t, double>, field<qty_t, int>>> cols;
+///     cols.push_back(make_record(price = 1.5, qty = 3));
+///     price(cols) // std::vector<double>&
+///
+/// Elements are accessed through zip::references, so anything which
+/// works with a zip::range works with columns too.
+///
+/// Every column allocates with Allocator, rebound to its value type. To
+/// keep the values' own allocations (of strings, say) in the same arena,
+/// use a std::scoped_allocator_adaptor.
+template <typename Record, typename Allocator = std::allocator<char>>
+class columns;
+
+template <typename... Symbols, typename... Values, typename Allocator>
+class columns<record<field<Symbols, Values>...>, Allocator>
+    : public record<field<Symbols, std::vector<Values, typename std::allocator_traits<Allocator>::template rebind_alloc<Values>>>...>
+{
+  template <typename Value>
+  using column = std::vector<Value, typename std::allocator_traits<Allocator>::template rebind_alloc<Value>>;
+
+  // every column has the same allocator, so any one can report it
+  using head_symbol = std::tuple_element_t<0, std::tuple<Symbols...>>;
+
+public:
+  static_assert(sizeof...(Symbols) != 0, "columns must have at least one field");
+
+  using value_type = record<field<Symbols, Values>...>;
+  using container_record = record<field<Symbols, column<Values>>...>;
+  using size_type = std::size_t;
+  using allocator_type = Allocator;
+
+  using range_type = zip::range<record<field<Symbols, column<Values> &>...>>;
+  using iterator = typename range_type::iterator;
+  using reference = typename iterator::reference;
+
+  using const_range_type = zip::range<record<field<Symbols, column<Values> const &>...>>;
+  using const_iterator = typename const_range_type::iterator;
+  using const_reference = typename const_iterator::reference;
+
+  columns() = default;
+
+  explicit columns(Allocator const &a)
+      : container_record{ column<Values>(a)... }
+  {
+  }
+
+  explicit columns(size_type n, Allocator const &a = Allocator{})
+      : container_record{ column<Values>(n, a)... }
+  {
+  }
+
+  allocator_type get_allocator() const
+  {
+    return allocator_type{ get(head_symbol{}, *this).get_allocator() };
+  }
+
+  range_type range()
+  {
+    return range_type{ make_field(Symbols{}, get(Symbols{}, *this))... };
+  }
+
+  const_range_type range() const
+  {
+    return const_range_type{ make_field(Symbols{}, get(Symbols{}, *this))... };
+  }
+
+  iterator begin()
+  {
+    return range().begin();
+  }
+
+  iterator end()
+  {
+    return range().end();
+  }
+
+  const_iterator begin() const
+  {
+    return range().begin();
+  }
+
+  const_iterator end() const
+  {
+    return range().end();
+  }
+
+  ///
+  /// see zip::range::chunks()
+  auto chunks(size_type n)
+  {
+    return range().chunks(n);
+  }
+
+  auto chunks(size_type n) const
+  {
+    return range().chunks(n);
+  }
+
+  reference operator[](size_type i)
+  {
+    return reference{ begin() + static_cast<std::ptrdiff_t>(i) };
+  }
+
+  const_reference operator[](size_type i) const
+  {
+    return const_reference{ begin() + static_cast<std::ptrdiff_t>(i) };
+  }
+
+  // every column has the same length, but ask all of them anyway
+  // so that columns of no particular length are never reported
+  size_type size() const
+  {
+    return std::min({ get(Symbols{}, *this).size()... });
+  }
+
+  bool empty() const
+  {
+    return size() == 0;
+  }
+
+  void reserve(size_type n)
+  {
+    symbol_set<Symbols...>{ (get(Symbols{}, *this).reserve(n), Symbols{})... };
+  }
+
+  void resize(size_type n)
+  {
+    symbol_set<Symbols...>{ (get(Symbols{}, *this).resize(n), Symbols{})... };
+  }
+
+  void clear()
+  {
+    symbol_set<Symbols...>{ (get(Symbols{}, *this).clear(), Symbols{})... };
+  }
+
+  ///
+  /// Append one field from Record to each column. Record need not be
+  /// value_type; any record with fields for all symbols will do.
+  /// If appending to any column throws, all columns are restored to
+  /// their previous length.
+  template <typename Record>
+  void push_back(Record &&r)
+  {
+    static_assert(has_all<symbol_set<Symbols...>, Record &&>, "fields were not defined on pushed record for all symbols in columns");
+    auto n = size();
+    try
+    {
+      symbol_set<Symbols...>{ (get(Symbols{}, *this).push_back(get(Symbols{}, std::forward<Record>(r))), Symbols{})... };
+    }
+    catch (...)
+    {
+      truncate_(n);
+      throw;
+    }
+  }
+
+  ///
+  /// Append the records in [first, last) to each column. When the
+  /// iterators are themselves over columns (a zip::iterator, or a columns'
+  /// iterator) each column is appended in one insert(), which for
+  /// trivially copyable values is a single memmove; otherwise records are
+  /// appended one by one as by push_back(). If appending throws, all
+  /// columns are restored to their previous length.
+  ///
+  /// The records may be these columns' own (cols.append(cols.begin(),
+  /// cols.end()), say): if the first record is stored here, the range is
+  /// copied out before anything is appended.
+  template <typename Iterator>
+  void append(Iterator first, Iterator last)
+  {
+    using columnwise = integer_constant<bool, all_true({ has_column_iterator<Symbols, Iterator>::value... })>;
+    auto n = size();
+    try
+    {
+      if (first != last && stored_here_(*first))
+      {
+        columns copy(get_allocator());
+        copy.append_(first, last, columnwise{});
+        symbol_set<Symbols...>{ (get(Symbols{}, *this).insert(get(Symbols{}, *this).end(),
+                                                              std::make_move_iterator(get(Symbols{}, copy).begin()),
+                                                              std::make_move_iterator(get(Symbols{}, copy).end())),
+                                 Symbols{})... };
+        return;
+      }
+      append_(first, last, columnwise{});
+    }
+    catch (...)
+    {
+      truncate_(n);
+      throw;
+    }
+  }
+
+private:
+  template <typename Iterator>
+  void append_(Iterator first, Iterator last, std::true_type /* columnwise */)
+  {
+    symbol_set<Symbols...>{ (get(Symbols{}, *this).insert(get(Symbols{}, *this).end(), get(Symbols{}, first), get(Symbols{}, last)), Symbols{})... };
+  }
+
+  template <typename Iterator>
+  void append_(Iterator first, Iterator last, std::false_type /* columnwise */)
+  {
+    for (; first != last; ++first)
+    {
+      decltype(auto) r = *first;
+      symbol_set<Symbols...>{ (get(Symbols{}, *this).push_back(get(Symbols{}, r)), Symbols{})... };
+    }
+  }
+
+  template <typename Record>
+  bool stored_here_(Record &&r) const
+  {
+    return std::max({ stored_in_(get(Symbols{}, *this), get(Symbols{}, r))... });
+  }
+
+  // whether e is an element of c. A proxy of the column's own reference
+  // type (std::vector<bool>'s) can't be located, so it is assumed to be.
+  template <typename Column, typename Element>
+  static bool stored_in_(Column const &c, Element const &e)
+  {
+    return stored_in_(c, e, std::is_reference<typename Column::reference>{});
+  }
+
+  template <typename Column, typename Element>
+  static bool stored_in_(Column const &, Element const &, std::false_type /* real references */)
+  {
+    return std::is_same<Element, typename Column::reference>::value;
+  }
+
+  template <typename Column, typename Element>
+  static bool stored_in_(Column const &c, Element const &e, std::true_type /* real references */)
+  {
+    return stored_at_(c, std::addressof(e), std::is_same<Element, typename Column::value_type>{});
+  }
+
+  template <typename Column, typename Element>
+  static bool stored_at_(Column const &, Element const *, std::false_type /* same type */)
+  {
+    return false;
+  }
+
+  template <typename Column, typename Element>
+  static bool stored_at_(Column const &c, Element const *e, std::true_type /* same type */)
+  {
+    std::less<Element const *> less;
+    return !less(e, c.data()) && less(e, c.data() + c.size());
+  }
+
+  void truncate_(size_type n)
+  {
+    symbol_set<Symbols...>{ (truncate_(get(Symbols{}, *this), n), Symbols{})... };
+  }
+
+  template <typename Column>
+  static void truncate_(Column &c, size_type n)
+  {
+    if (c.size() > n)
+    {
+      c.erase(c.begin() + static_cast<std::ptrdiff_t>(n), c.end());
+    }
+  }
+};
+
+} // namespace
+} // namespace rekt
@@ -0,0 +1,206 @@
+/// Copyright (c) Benjamin Kietzman (github.com/bkietz)
+///
+/// Distributed under the Boost Software License, Version 1.0. (See accompanying
+/// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace rekt
+{
+namespace
+{
+
+///
+/// Fibonacci hashing: multiply by 2^64 / phi. The high bits of the product
+/// depend on every bit of h, so tables index with those. (std::hash of
+/// an integer is often the integer itself, whose low bits alone make a
+/// poor index into a power of two table.)
+constexpr std::uint64_t mix_hash(std::size_t h)
+{
+  return static_cast<std::uint64_t>(h) * 0x9E3779B97F4A7C15ULL;
+}
+
+///
+/// An open addressing (linear probing) table of row numbers, keyed by
+/// whatever the caller hashes and compares. Rows with equal keys are
+/// chained together in the order they were inserted, so the table holds
+/// one slot per distinct key:
+///
+///     hash_index index(rows);
+///     index.insert(h(key[row]), row, [&](std::size_t other) { return key[other] == key[row]; });
+///     for (auto r = index.find(h(k), equal_to_k); r != hash_index::npos; r = index.next(r))
+///       ...
+class hash_index
+{
+public:
+  static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+  ///
+  /// expected_keys is a hint; the table grows if more distinct keys are inserted
+  explicit hash_index(std::size_t expected_keys = 0)
+      : slots_(capacity_for_(expected_keys))
+  {
+    set_shift_();
+  }
+
+  ///
+  /// Insert row with the given (unmixed) hash. same_key(other) must report
+  /// whether a previously inserted row has the same key as row.
+  /// Returns the first row inserted with that key (row itself if the key is new).
+  template <typename SameKey>
+  std::size_t insert(std::size_t hash, std::size_t row, SameKey &&same_key)
+  {
+    reserve_rows_(row);
+
+    auto mixed = mix_hash(hash);
+    auto &s = slots_[probe_(mixed, same_key)];
+    if (s.first == npos)
+    {
+      s = slot{ mixed, row };
+      if (++keys_ * 2 > slots_.size())
+      {
+        grow_();
+      }
+      return row;
+    }
+    next_[last_[s.first]] = row;
+    last_[s.first] = row;
+    return s.first;
+  }
+
+  ///
+  /// Like insert(), but row is only inserted if its key is new;
+  /// rows with keys already in the table are not chained. No chains are
+  /// kept at all, so a table filled this way takes no per-row storage
+  /// (and shouldn't also be filled with insert()).
+  template <typename SameKey>
+  std::size_t find_or_insert(std::size_t hash, std::size_t row, SameKey &&same_key)
+  {
+    auto mixed = mix_hash(hash);
+    auto &s = slots_[probe_(mixed, same_key)];
+    if (s.first != npos)
+    {
+      return s.first;
+    }
+    s = slot{ mixed, row };
+    if (++keys_ * 2 > slots_.size())
+    {
+      grow_();
+    }
+    return row;
+  }
+
+  ///
+  /// The first row inserted with a key for which same_key(row) is true, or npos
+  template <typename SameKey>
+  std::size_t find(std::size_t hash, SameKey &&same_key) const
+  {
+    return slots_[probe_(mix_hash(hash), same_key)].first;
+  }
+
+  ///
+  /// The row inserted after row with the same key, or npos
+  std::size_t next(std::size_t row) const
+  {
+    return next_[row];
+  }
+
+  ///
+  /// number of distinct keys
+  std::size_t size() const
+  {
+    return keys_;
+  }
+
+private:
+  struct slot
+  {
+    std::uint64_t hash = 0;
+    std::size_t first = npos;
+  };
+
+  // home slots are the top log2(capacity) bits of a mixed hash
+  void set_shift_()
+  {
+    shift_ = 64;
+    for (auto capacity = slots_.size(); capacity != 1; capacity /= 2)
+    {
+      --shift_;
+    }
+  }
+
+  void reserve_rows_(std::size_t row)
+  {
+    if (row >= next_.size())
+    {
+      next_.resize(std::max(row + 1, next_.size() * 2), npos);
+      last_.resize(next_.size());
+    }
+    next_[row] = npos;
+    last_[row] = row;
+  }
+
+  // at most half full
+  static std::size_t capacity_for_(std::size_t keys)
+  {
+    std::size_t capacity = 16;
+    while (capacity < keys * 2)
+    {
+      capacity *= 2;
+    }
+    return capacity;
+  }
+
+  // the slot holding the key, or the empty slot where it belongs
+  template <typename SameKey>
+  std::size_t probe_(std::uint64_t hash, SameKey &same_key) const
+  {
+    auto mask = slots_.size() - 1;
+    for (auto i = static_cast<std::size_t>(hash >> shift_);; i = (i + 1) & mask)
+    {
+      auto const &s = slots_[i];
+      if (s.first == npos || (s.hash == hash && same_key(s.first)))
+      {
+        return i;
+      }
+    }
+  }
+
+  void grow_()
+  {
+    std::vector<slot> slots(slots_.size() * 2);
+    slots.swap(slots_);
+    set_shift_();
+    auto mask = slots_.size() - 1;
+    for (auto const &s : slots)
+    {
+      if (s.first == npos)
+      {
+        continue;
+      }
+      auto i = static_cast<std::size_t>(s.hash >> shift_);
+      while (slots_[i].first != npos)
+      {
+        i = (i + 1) & mask;
+      }
+      slots_[i] = s;
+    }
+  }
+
+  std::vector<slot> slots_;
+  // for each row, the next row with the same key; for each
+  // first row of a key, the last row with that key
+  std::vector<std::size_t> next_, last_;
+  std::size_t keys_ = 0;
+  unsigned shift_;
+};
+
+constexpr std::size_t hash_index::npos;
+
+} // namespace
+} // namespace rekt
@@ -0,0 +1,173 @@
+/// Copyright (c) Benjamin Kietzman (github.com/bkietz)
+///
+/// Distributed under the Boost Software License, Version 1.0. (See accompanying
+/// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <rekt/utility.hpp>
+#include <vector>
+
+namespace rekt
+{
+namespace
+{
+
+template <std::size_t Size>
+struct unsigned_of_size;
+
+template <>
+struct unsigned_of_size<1>
+{
+  using type = std::uint8_t;
+};
+
+template <>
+struct unsigned_of_size<2>
+{
+  using type = std::uint16_t;
+};
+
+template <>
+struct unsigned_of_size<4>
+{
+  using type = std::uint32_t;
+};
+
+template <>
+struct unsigned_of_size<8>
+{
+  using type = std::uint64_t;
+};
+
+///
+/// radix_key maps a Key to an unsigned integer such that comparing
+/// encoded keys as unsigned integers orders them as Keys would be.
+/// Only defined for integral, enum, float, and double keys.
+template <typename Key, typename Enable = void>
+struct radix_key
+{
+  static constexpr bool value = false;
+};
+
+template <typename Key>
+struct radix_key<Key, std::enable_if_t<std::is_integral<Key>::value>>
+{
+  static constexpr bool value = true;
+  using type = typename unsigned_of_size<sizeof(Key)>::type;
+
+  static constexpr type encode(Key k)
+  {
+    // flip the sign bit so negative keys sort below positive ones
+    return std::is_signed<Key>::value
+        ? static_cast<type>(static_cast<type>(k) ^ (type(1) << (sizeof(Key) * 8 - 1)))
+        : static_cast<type>(k);
+  }
+};
+
+template <typename Key>
+struct radix_key<Key, std::enable_if_t<std::is_enum<Key>::value>>
+    : radix_key<std::underlying_type_t<Key>>
+{
+  using underlying = radix_key<std::underlying_type_t<Key>>;
+
+  static constexpr typename underlying::type encode(Key k)
+  {
+    return underlying::encode(static_cast<std::underlying_type_t<Key>>(k));
+  }
+};
+
+// NB: -0.0 sorts before 0.0 and NaNs sort to the ends
+template <typename Key>
+struct radix_key<Key, std::enable_if_t<std::is_floating_point<Key>::value && std::numeric_limits<Key>::is_iec559 && (sizeof(Key) == 4 || sizeof(Key) == 8)>>
+{
+  static constexpr bool value = true;
+  using type = typename unsigned_of_size<sizeof(Key)>::type;
+
+  static type encode(Key k)
+  {
+    type bits;
+    std::memcpy(&bits, &k, sizeof(Key));
+    constexpr type sign = type(1) << (sizeof(Key) * 8 - 1);
+    // negative: reverse the order of magnitudes, positive: move above negatives
+    return (bits & sign) ? ~bits : (bits | sign);
+  }
+};
+
+///
+/// Stable least significant digit radix sort of encoded keys, applying
+/// the same moves to a parallel array of row indices. Passes for digits
+/// which are the same in every key are skipped.
+template <typename Unsigned>
+void radix_sort(std::vector<Unsigned> &keys, std::vector<std::size_t> &indices)
+{
+  // keys travel with their (narrowed, when possible) indices
+  // so that each scatter writes to one place rather than two
+  if (indices.size() <= std::numeric_limits<std::uint32_t>::max())
+  {
+    radix_sort(keys, indices, type_c<std::uint32_t>);
+  }
+  else
+  {
+    radix_sort(keys, indices, type_c<std::size_t>);
+  }
+}
+
+template <typename Unsigned, typename Index>
+void radix_sort(std::vector<Unsigned> &keys, std::vector<std::size_t> &indices, type_constant<Index>)
+{
+  struct entry
+  {
+    Unsigned key;
+    Index index;
+  };
+
+  std::size_t const n = keys.size();
+  std::vector<entry> entries(n), buffer(n);
+  for (std::size_t i = 0; i != n; ++i)
+  {
+    entries[i] = entry{ keys[i], static_cast<Index>(indices[i]) };
+  }
+
+  for (std::size_t shift = 0; shift != sizeof(Unsigned) * 8; shift += 8)
+  {
+    std::array<std::size_t, 256> offsets{};
+    for (auto const &e : entries)
+    {
+      ++offsets[(e.key >> shift) & 0xFF];
+    }
+
+    if (std::find(offsets.begin(), offsets.end(), n) != offsets.end())
+    {
+      continue;
+    }
+
+    std::size_t sum = 0;
+    for (auto &offset : offsets)
+    {
+      auto count = offset;
+      offset = sum;
+      sum += count;
+    }
+
+    for (auto const &e : entries)
+    {
+      buffer[offsets[(e.key >> shift) & 0xFF]++] = e;
+    }
+    entries.swap(buffer);
+  }
+
+  for (std::size_t i = 0; i != n; ++i)
+  {
+    keys[i] = entries[i].key;
+    indices[i] = entries[i].index;
+  }
+}
+
+} // namespace
+} // namespace rekt
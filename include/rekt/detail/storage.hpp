@@ -4,6 +4,7 @@
 /// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
 
 #pragma once
+#include <memory>
 #include <rekt/utility.hpp>
 
 namespace rekt
@@ -11,6 +12,22 @@ namespace rekt
 namespace
 {
 
+///
+/// How uses-allocator construction builds a Value from an allocator and
+/// some arguments: 0 ignores the allocator (Value doesn't use one),
+/// 1 passes std::allocator_arg and the allocator first, 2 passes the
+/// allocator last
+template <typename Value, typename Alloc, typename... Args>
+constexpr int uses_allocator_form()
+{
+  return !std::uses_allocator<Value, Alloc>::value
+             ? 0
+             : std::is_constructible<Value, std::allocator_arg_t, Alloc const &, Args...>::value ? 1 : 2;
+}
+
+template <typename Value, typename Alloc, typename... Args>
+using uses_allocator_form_t = integer_constant<int, uses_allocator_form<Value, Alloc, Args...>()>;
+
 template <typename Value, bool IsEmpty>
 class storage;
 
@@ -26,6 +43,14 @@ public:
   {
   }
 
+  ///
+  /// uses-allocator construction of the value
+  template <typename Alloc, typename... Args>
+  constexpr storage(std::allocator_arg_t, Alloc const &a, Args &&... args)
+      : storage(uses_allocator_form_t<Value, Alloc, Args...>{}, a, std::forward<Args>(args)...)
+  {
+  }
+
   constexpr decltype(auto) value() const
   {
     auto t = if_constexpr(std::is_reference<value_type>{},
@@ -43,6 +68,24 @@ public:
   }
 
 private:
+  template <typename Alloc, typename... Args>
+  constexpr storage(integer_constant<int, 0>, Alloc const &, Args &&... args)
+      : value_{ std::forward<Args>(args)... }
+  {
+  }
+
+  template <typename Alloc, typename... Args>
+  constexpr storage(integer_constant<int, 1>, Alloc const &a, Args &&... args)
+      : value_{ std::allocator_arg, a, std::forward<Args>(args)... }
+  {
+  }
+
+  template <typename Alloc, typename... Args>
+  constexpr storage(integer_constant<int, 2>, Alloc const &a, Args &&... args)
+      : value_{ std::forward<Args>(args)..., a }
+  {
+  }
+
   value_type value_;
 };
 
@@ -75,6 +118,12 @@ public:
   {
   }
 
+  template <typename Alloc, typename... Args>
+  constexpr storage(std::allocator_arg_t, Alloc const &a, Args &&... args)
+      : storage(uses_allocator_form_t<EmptyValue, Alloc, Args...>{}, a, std::forward<Args>(args)...)
+  {
+  }
+
   constexpr decltype(auto) value() const
   {
     return static_cast<value_type const &>(*this);
@@ -84,6 +133,25 @@ public:
   {
     return static_cast<value_type &>(*this);
   }
+
+private:
+  template <typename Alloc, typename... Args>
+  constexpr storage(integer_constant<int, 0>, Alloc const &, Args &&... args)
+      : value_type{ std::forward<Args>(args)... }
+  {
+  }
+
+  template <typename Alloc, typename... Args>
+  constexpr storage(integer_constant<int, 1>, Alloc const &a, Args &&... args)
+      : value_type{ std::allocator_arg, a, std::forward<Args>(args)... }
+  {
+  }
+
+  template <typename Alloc, typename... Args>
+  constexpr storage(integer_constant<int, 2>, Alloc const &a, Args &&... args)
+      : value_type{ std::forward<Args>(args)..., a }
+  {
+  }
 };
 
 
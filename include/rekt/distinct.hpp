@@ -0,0 +1,64 @@
+/// Copyright (c) Benjamin Kietzman (github.com/bkietz)
+///
+/// Distributed under the Boost Software License, Version 1.0. (See accompanying
+/// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <rekt/detail/hash_index.hpp>
+#include <rekt/hash.hpp>
+#include <rekt/selection.hpp>
+
+namespace rekt
+{
+namespace
+{
+
+///
+/// rows are hashed this many at a time, a column at a time
+constexpr std::size_t distinct_block_rows = 4096;
+
+///
+/// Select the first row of a random access zip::range (or columns) with
+/// each distinct combination of some fields, so the result can be passed
+/// to filter() or materialize():
+///
+///     auto firsts = distinct(people, city, age);
+///     auto one_per_city_and_age = materialize(people, firsts, name, city, age);
+///
+/// Rows are hashed as by hash_fields(), but a block of each column at a
+/// time, and the first row with each new combination is kept in a
+/// hash_index. Only the given fields are read, and no row is copied.
+template <typename Range, typename... Symbols>
+selection distinct(Range &&zipped, Symbols const &... symbols)
+{
+  static_assert(sizeof...(Symbols) != 0, "at least one symbol is required");
+  auto first = zipped.begin();
+  auto n = static_cast<std::size_t>(zipped.end() - first);
+
+  hash_index index;
+  std::vector<std::size_t> firsts, hashes(distinct_block_rows);
+  auto it = first;
+  for (std::size_t offset = 0; offset < n; offset += distinct_block_rows)
+  {
+    auto rows = std::min(distinct_block_rows, n - offset);
+    hash_columns(first + static_cast<std::ptrdiff_t>(offset), rows, hashes.data(), symbols...);
+    for (std::size_t row = 0; row != rows; ++row, ++it)
+    {
+      auto &&r = *it;
+      // index rows are numbered by rank among the first rows, so the
+      // index needs no storage for rows which turn out to be duplicates
+      auto rank = index.find_or_insert(hashes[row], firsts.size(), [&](std::size_t other) {
+        return equal_fields(first[static_cast<std::ptrdiff_t>(firsts[other])], r, symbols...);
+      });
+      if (rank == firsts.size())
+      {
+        firsts.push_back(offset + row);
+      }
+    }
+  }
+  return selection{ std::move(firsts), n };
+}
+
+} // namespace
+} // namespace rekt
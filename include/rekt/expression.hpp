@@ -0,0 +1,232 @@
+/// Copyright (c) Benjamin Kietzman (github.com/bkietz)
+///
+/// Distributed under the Boost Software License, Version 1.0. (See accompanying
+/// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <rekt/bitmap.hpp>
+#include <rekt/iterator.hpp>
+
+namespace rekt
+{
+namespace
+{
+
+///
+/// Boolean expressions of the fields of a row, built from comparisons
+/// between symbols and values:
+///
+///     auto adult_and_short = age > 18 && height < 2.0;
+///     adult_and_short(row)                      // for one row
+///     where(zip(age = ages, height = heights), adult_and_short) // a bitmap of all rows
+///
+/// Evaluated over a range, each comparison runs over its column alone,
+/// a block of rows at a time, packing results into words of a bitmap;
+/// && || and ! then combine whole words.
+template <typename Expression>
+struct expression
+{
+  Expression const &derived() const
+  {
+    return static_cast<Expression const &>(*this);
+  }
+};
+
+///
+/// rows are evaluated in blocks of this many, so that && and || can
+/// combine the results of their operands through buffers on the stack
+constexpr std::size_t expression_block_rows = 2048;
+
+template <typename Symbol, typename Value, typename Compare>
+struct comparison : expression<comparison<Symbol, Value, Compare>>
+{
+  Value value;
+
+  explicit comparison(Value v)
+      : value(std::move(v))
+  {
+  }
+
+  template <typename Row>
+  bool operator()(Row const &row) const
+  {
+    return Compare{}(get(Symbol{}, row), value);
+  }
+
+  ///
+  /// write the results for n (at most expression_block_rows) rows from rows
+  /// into bitmap::words_for(n) words
+  template <typename Iterator>
+  void evaluate(Iterator rows, std::size_t n, bitmap::word_type *words) const
+  {
+    // comparing into bytes first keeps the comparisons independent
+    // of each other (and so vectorizable for arithmetic columns)
+    auto column = get(Symbol{}, rows);
+    unsigned char flags[bitmap::word_bits];
+    std::size_t w = 0;
+    for (; (w + 1) * bitmap::word_bits <= n; ++w)
+    {
+      for (std::size_t b = 0; b != bitmap::word_bits; ++b, ++column)
+      {
+        flags[b] = Compare{}(*column, value);
+      }
+      words[w] = bitmap::pack(flags);
+    }
+    if (w * bitmap::word_bits != n)
+    {
+      std::fill(std::begin(flags), std::end(flags), 0);
+      for (std::size_t b = 0; b != n - w * bitmap::word_bits; ++b, ++column)
+      {
+        flags[b] = Compare{}(*column, value);
+      }
+      words[w] = bitmap::pack(flags);
+    }
+  }
+};
+
+template <typename Left, typename Right, typename Combine>
+struct combination : expression<combination<Left, Right, Combine>>
+{
+  Left left;
+  Right right;
+
+  combination(Left l, Right r)
+      : left(std::move(l)), right(std::move(r))
+  {
+  }
+
+  template <typename Row>
+  bool operator()(Row const &row) const
+  {
+    return Combine{}(left(row), right(row));
+  }
+
+  template <typename Iterator>
+  void evaluate(Iterator rows, std::size_t n, bitmap::word_type *words) const
+  {
+    bitmap::word_type right_words[bitmap::words_for(expression_block_rows)];
+    left.evaluate(rows, n, words);
+    right.evaluate(rows, n, right_words);
+    for (std::size_t w = 0; w != bitmap::words_for(n); ++w)
+    {
+      words[w] = Combine{}(words[w], right_words[w]);
+    }
+  }
+};
+
+template <typename Operand>
+struct negation : expression<negation<Operand>>
+{
+  Operand operand;
+
+  explicit negation(Operand o)
+      : operand(std::move(o))
+  {
+  }
+
+  template <typename Row>
+  bool operator()(Row const &row) const
+  {
+    return !operand(row);
+  }
+
+  template <typename Iterator>
+  void evaluate(Iterator rows, std::size_t n, bitmap::word_type *words) const
+  {
+    operand.evaluate(rows, n, words);
+    for (std::size_t w = 0; w != bitmap::words_for(n); ++w)
+    {
+      words[w] = ~words[w];
+    }
+    if (n % bitmap::word_bits != 0)
+    {
+      words[n / bitmap::word_bits] &= (bitmap::word_type(1) << (n % bitmap::word_bits)) - 1;
+    }
+  }
+};
+
+template <typename Value>
+struct is_symbol_or_expression
+{
+  template <typename S>
+  static std::true_type test(symbol<S> const *);
+
+  template <typename E>
+  static std::true_type test(expression<E> const *);
+
+  static std::false_type test(...);
+
+  static constexpr bool value = decltype(test(std::declval<std::decay_t<Value> const *>()))::value;
+};
+
+template <typename Value>
+using enable_if_operand_t = std::enable_if_t<!is_symbol_or_expression<Value>::value>;
+
+// Comparisons between a symbol and a value. Comparisons between two symbols
+// are left to record.hpp, which defines == and != to compare symbol types.
+#define REKT_EXPRESSION_COMPARISON(op, compare, reversed)                                        \
+  template <typename Symbol, typename Value, typename = enable_if_operand_t<Value>>              \
+  auto operator op(symbol<Symbol> const &, Value &&v)                                            \
+  {                                                                                              \
+    return comparison<Symbol, std::decay_t<Value>, compare>{ std::forward<Value>(v) };           \
+  }                                                                                              \
+                                                                                                 \
+  template <typename Value, typename Symbol, typename = enable_if_operand_t<Value>>              \
+  auto operator op(Value &&v, symbol<Symbol> const &)                                            \
+  {                                                                                              \
+    return comparison<Symbol, std::decay_t<Value>, reversed>{ std::forward<Value>(v) };          \
+  }
+
+REKT_EXPRESSION_COMPARISON(==, std::equal_to<>, std::equal_to<>)
+REKT_EXPRESSION_COMPARISON(!=, std::not_equal_to<>, std::not_equal_to<>)
+REKT_EXPRESSION_COMPARISON(<, std::less<>, std::greater<>)
+REKT_EXPRESSION_COMPARISON(<=, std::less_equal<>, std::greater_equal<>)
+REKT_EXPRESSION_COMPARISON(>, std::greater<>, std::less<>)
+REKT_EXPRESSION_COMPARISON(>=, std::greater_equal<>, std::less_equal<>)
+
+#undef REKT_EXPRESSION_COMPARISON
+
+template <typename Left, typename Right>
+auto operator&&(expression<Left> const &l, expression<Right> const &r)
+{
+  return combination<Left, Right, std::bit_and<>>{ l.derived(), r.derived() };
+}
+
+template <typename Left, typename Right>
+auto operator||(expression<Left> const &l, expression<Right> const &r)
+{
+  return combination<Left, Right, std::bit_or<>>{ l.derived(), r.derived() };
+}
+
+template <typename Operand>
+auto operator!(expression<Operand> const &o)
+{
+  return negation<Operand>{ o.derived() };
+}
+
+///
+/// Evaluate an expression for each row of a zip::range (or columns),
+/// a column at a time. Bit i of the result is set if row i satisfied it.
+template <typename Range, typename Expression>
+bitmap where(Range &&zipped, expression<Expression> const &e)
+{
+  auto first = zipped.begin();
+  auto last = zipped.end();
+  auto n = static_cast<std::size_t>(std::distance(first, last));
+
+  bitmap selected(n);
+  for (std::size_t offset = 0; offset != n;)
+  {
+    auto rows = std::min(expression_block_rows, n - offset);
+    e.derived().evaluate(first, rows, selected.words() + offset / bitmap::word_bits);
+    std::advance(first, static_cast<std::ptrdiff_t>(rows));
+    offset += rows;
+  }
+  return selected;
+}
+
+} // namespace
+} // namespace rekt
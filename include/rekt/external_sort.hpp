@@ -0,0 +1,395 @@
+/// Copyright (c) Benjamin Kietzman (github.com/bkietz)
+///
+/// Distributed under the Boost Software License, Version 1.0. (See accompanying
+/// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <rekt/columns.hpp>
+#include <rekt/sort.hpp>
+#include <stdexcept>
+#include <string>
+
+namespace rekt
+{
+namespace
+{
+
+///
+/// memory external_sort() may use when no budget is given
+constexpr std::size_t default_external_sort_budget = std::size_t(256) << 20;
+
+///
+/// the most runs merged at once; more runs are merged in several passes
+constexpr std::size_t external_sort_fan_in = 16;
+
+///
+/// memory counted against the budget for each open file: the stream and
+/// its buffer
+constexpr std::size_t external_sort_stream_bytes = sizeof(std::fstream) + BUFSIZ;
+
+///
+/// Temporary files holding sorted runs, removed on destruction.
+/// Each run is stored as its columns, one after another.
+class external_sort_runs
+{
+public:
+  explicit external_sort_runs(std::string tmpdir)
+      : prefix_{ std::move(tmpdir) + "/rekt-external-sort-" +
+                 std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) + "-" +
+                 std::to_string(reinterpret_cast<std::uintptr_t>(this)) + "-" }
+  {
+  }
+
+  external_sort_runs(external_sort_runs const &) = delete;
+  external_sort_runs &operator=(external_sort_runs const &) = delete;
+
+  ~external_sort_runs()
+  {
+    for (std::size_t i = 0; i != rows_.size(); ++i)
+    {
+      remove(i);
+    }
+  }
+
+  std::size_t size() const
+  {
+    return rows_.size();
+  }
+
+  std::size_t rows(std::size_t run) const
+  {
+    return rows_[run];
+  }
+
+  std::string path(std::size_t run) const
+  {
+    return prefix_ + std::to_string(run);
+  }
+
+  ///
+  /// a new (empty) run of some number of rows
+  std::size_t add(std::size_t rows)
+  {
+    rows_.push_back(rows);
+    removed_.push_back(false);
+    auto run = rows_.size() - 1;
+    if (!std::ofstream(path(run), std::ios::binary | std::ios::trunc))
+    {
+      throw std::runtime_error("external_sort(): could not write " + path(run));
+    }
+    return run;
+  }
+
+  ///
+  /// a new run holding all the rows of some columns
+  template <typename... Symbols, typename... Values>
+  void write(columns<record<field<Symbols, Values>...>> const &run)
+  {
+    auto r = add(run.size());
+    std::ofstream file(path(r), std::ios::binary | std::ios::trunc);
+    symbol_set<Symbols...>{ (file.write(reinterpret_cast<char const *>(get(Symbols{}, run).data()),
+                                        static_cast<std::streamsize>(run.size() * sizeof(Values))),
+                             Symbols{})... };
+    if (!file.flush())
+    {
+      throw std::runtime_error("external_sort(): could not write " + path(r));
+    }
+  }
+
+  ///
+  /// remove a run's file once it has been merged
+  void remove(std::size_t run)
+  {
+    if (!removed_[run])
+    {
+      std::remove(path(run).c_str());
+      removed_[run] = true;
+    }
+  }
+
+private:
+  std::string prefix_;
+  std::vector<std::size_t> rows_;
+  std::vector<bool> removed_;
+};
+
+///
+/// Writes a run, a block of rows at a time
+template <typename Record>
+class external_sort_writer;
+
+template <typename... Symbols, typename... Values>
+class external_sort_writer<record<field<Symbols, Values>...>>
+{
+public:
+  external_sort_writer(external_sort_runs const &runs, std::size_t run, std::size_t block_rows)
+      : path_{ runs.path(run) }, file_{ path_, std::ios::binary | std::ios::in | std::ios::out },
+        rows_{ runs.rows(run) }, block_rows_{ block_rows }
+  {
+    block_.reserve(block_rows_);
+  }
+
+  template <typename Row>
+  void push_back(Row const &row)
+  {
+    block_.push_back(row);
+    if (block_.size() == block_rows_)
+    {
+      flush();
+    }
+  }
+
+  ///
+  /// write out the buffered rows
+  void flush()
+  {
+    // columns are stored one after another, so column c starts after
+    // rows_ elements of each column before it
+    std::size_t column_offset = 0;
+    (void)std::initializer_list<int>{ (write_(get(Symbols{}, block_).data(), column_offset + written_ * sizeof(Values)),
+                                       column_offset += rows_ * sizeof(Values),
+                                       0)... };
+    written_ += block_.size();
+    block_.clear();
+    if (!file_.flush())
+    {
+      throw std::runtime_error("external_sort(): could not write " + path_);
+    }
+  }
+
+private:
+  template <typename Value>
+  void write_(Value const *in, std::size_t offset)
+  {
+    file_.seekp(static_cast<std::streamoff>(offset));
+    file_.write(reinterpret_cast<char const *>(in), static_cast<std::streamsize>(block_.size() * sizeof(Value)));
+  }
+
+  std::string path_;
+  std::fstream file_;
+  std::size_t rows_, block_rows_, written_ = 0;
+  columns<record<field<Symbols, Values>...>> block_;
+};
+
+///
+/// Reads a run back, a block of rows at a time
+template <typename Record>
+class external_sort_reader;
+
+template <typename... Symbols, typename... Values>
+class external_sort_reader<record<field<Symbols, Values>...>>
+{
+public:
+  external_sort_reader(external_sort_runs const &runs, std::size_t run, std::size_t block_rows)
+      : file_{ runs.path(run), std::ios::binary }, rows_{ runs.rows(run) }, block_rows_{ block_rows }
+  {
+    if (!file_)
+    {
+      throw std::runtime_error("external_sort(): could not read " + runs.path(run));
+    }
+    refill_();
+  }
+
+  bool done() const
+  {
+    return position_ == block_.size();
+  }
+
+  columns<record<field<Symbols, Values>...>> const &block() const
+  {
+    return block_;
+  }
+
+  std::size_t position() const
+  {
+    return position_;
+  }
+
+  void next()
+  {
+    if (++position_ == block_.size())
+    {
+      refill_();
+    }
+  }
+
+private:
+  void refill_()
+  {
+    auto rows = std::min(block_rows_, rows_ - consumed_);
+    block_.resize(rows);
+    position_ = 0;
+
+    std::size_t column_offset = 0;
+    (void)std::initializer_list<int>{ (read_(get(Symbols{}, block_).data(), column_offset + consumed_ * sizeof(Values), rows),
+                                       column_offset += rows_ * sizeof(Values),
+                                       0)... };
+    consumed_ += rows;
+  }
+
+  template <typename Value>
+  void read_(Value *out, std::size_t offset, std::size_t rows)
+  {
+    file_.seekg(static_cast<std::streamoff>(offset));
+    if (!file_.read(reinterpret_cast<char *>(out), static_cast<std::streamsize>(rows * sizeof(Value))))
+    {
+      throw std::runtime_error("external_sort(): a run was truncated");
+    }
+  }
+
+  std::ifstream file_;
+  std::size_t rows_, block_rows_, consumed_ = 0, position_ = 0;
+  columns<record<field<Symbols, Values>...>> block_;
+};
+
+///
+/// Merge some runs (earlier runs first among equal keys, so the merge is
+/// stable), passing each reader to emit() when its current row is next
+template <typename Record, typename Key, typename Emit>
+void merge_runs(external_sort_runs const &runs, std::size_t first_run, std::size_t last_run, std::size_t block_rows,
+                Key const &key, Emit &&emit)
+{
+  std::vector<external_sort_reader<Record>> readers;
+  readers.reserve(last_run - first_run);
+  for (auto r = first_run; r != last_run; ++r)
+  {
+    readers.emplace_back(runs, r, block_rows);
+  }
+
+  // whether run l's next row comes after run r's
+  auto after = [&](std::size_t l, std::size_t r) {
+    auto const &lk = get(key, readers[l].block())[readers[l].position()];
+    auto const &rk = get(key, readers[r].block())[readers[r].position()];
+    return rk < lk || (!(lk < rk) && l > r);
+  };
+  std::vector<std::size_t> heap(readers.size());
+  std::iota(heap.begin(), heap.end(), std::size_t(0));
+  heap.erase(std::remove_if(heap.begin(), heap.end(), [&](std::size_t r) { return readers[r].done(); }), heap.end());
+  std::make_heap(heap.begin(), heap.end(), after);
+
+  while (!heap.empty())
+  {
+    std::pop_heap(heap.begin(), heap.end(), after);
+    auto &reader = readers[heap.back()];
+    emit(reader);
+    reader.next();
+    if (reader.done())
+    {
+      heap.pop_back();
+    }
+    else
+    {
+      std::push_heap(heap.begin(), heap.end(), after);
+    }
+  }
+}
+
+template <typename Iterator, typename Key, typename... Symbols, typename... Values>
+void external_sort(Iterator first, std::size_t n, Key const &key, std::string const &tmpdir, std::size_t memory_budget,
+                   type_constant<record<field<Symbols, Values>...>>)
+{
+  static_assert(all_true({ std::is_trivially_copyable<Values>::value... }),
+                "external_sort writes columns to disk as bytes, so they must be trivially copyable");
+  using value_type = record<field<Symbols, Values>...>;
+  constexpr std::size_t row_bytes = sum_of({ sizeof(Values)... });
+
+  // sorting a run needs room for the run, a copy of each column as it
+  // is gathered, and a permutation of row indices with their keys
+  auto run_rows = std::max(std::size_t(1), memory_budget / (2 * row_bytes + 3 * sizeof(std::size_t)));
+  if (n <= run_rows)
+  {
+    auto indices = sort_permutation(first, n, key);
+    gather(first, indices);
+    return;
+  }
+
+  external_sort_runs runs(tmpdir);
+  {
+    columns<value_type> run;
+    for (std::size_t begin = 0; begin < n; begin += run_rows)
+    {
+      auto rows = std::min(run_rows, n - begin);
+      run.resize(rows);
+      symbol_set<Symbols...>{ (std::copy_n(get(Symbols{}, first) + static_cast<std::ptrdiff_t>(begin), rows, get(Symbols{}, run).begin()), Symbols{})... };
+      sort_by(run, key);
+      runs.write(run);
+    }
+  }
+
+  // each merge has at most fan_in open readers and one writer, each with
+  // a stream and a block of rows; a budget too small for that still gets
+  // two readers of one row each
+  auto fan_in = std::min(external_sort_fan_in, std::max(std::size_t(2), memory_budget / (external_sort_stream_bytes + 64 * row_bytes)));
+  auto share = memory_budget / (fan_in + 1);
+  auto block_rows = std::max(std::size_t(1), share > external_sort_stream_bytes ? (share - external_sort_stream_bytes) / row_bytes : 0);
+
+  // merge consecutive groups of fan_in runs into longer runs, keeping
+  // them in order so that the final merge stays stable
+  std::size_t pass_first = 0, pass_last = runs.size();
+  while (pass_last - pass_first > fan_in)
+  {
+    for (auto group = pass_first; group < pass_last; group += fan_in)
+    {
+      auto group_last = std::min(group + fan_in, pass_last);
+      std::size_t rows = 0;
+      for (auto r = group; r != group_last; ++r)
+      {
+        rows += runs.rows(r);
+      }
+      external_sort_writer<value_type> writer(runs, runs.add(rows), block_rows);
+      merge_runs<value_type>(runs, group, group_last, block_rows, key, [&](auto const &reader) {
+        writer.push_back(reader.block()[reader.position()]);
+      });
+      writer.flush();
+      for (auto r = group; r != group_last; ++r)
+      {
+        runs.remove(r);
+      }
+    }
+    pass_first = pass_last;
+    pass_last = runs.size();
+  }
+
+  std::ptrdiff_t out = 0;
+  merge_runs<value_type>(runs, pass_first, pass_last, block_rows, key, [&](auto const &reader) {
+    symbol_set<Symbols...>{ (get(Symbols{}, first)[out] = get(Symbols{}, reader.block())[reader.position()], Symbols{})... };
+    ++out;
+  });
+}
+
+///
+/// Stable sort of a random access zip::range (or columns) by one field,
+/// using about memory_budget bytes besides the range itself:
+///
+///     external_sort(zip(key = keys, a = as), key, "/tmp", 64 << 20);
+///
+/// Ranges which don't fit in the budget are copied into runs which do.
+/// Each run is sorted with sort_by() and written to a temporary file in
+/// tmpdir, column by column. The runs are then merged back into the
+/// range, reading a block of each at a time. At most external_sort_fan_in
+/// runs are merged at once; if there are more, passes merge consecutive
+/// groups of them into longer runs first. Each open file's stream and
+/// buffer count against the budget, as do the blocks. The temporary files
+/// are removed as soon as they are merged, and all are gone on return.
+///
+/// The range need not be in memory (its columns may be memory mapped, for
+/// example), but its fields must be trivially copyable. Budgets too small
+/// for a stream and a row for each of two runs are exceeded by that much.
+/// Throws std::runtime_error if the temporary files cannot be written or
+/// read.
+template <typename Range, typename Key>
+void external_sort(Range &&zipped, Key const &key, std::string const &tmpdir,
+                   std::size_t memory_budget = default_external_sort_budget)
+{
+  auto first = zipped.begin();
+  auto n = static_cast<std::size_t>(zipped.end() - first);
+  using value_type = typename std::iterator_traits<decltype(first)>::value_type;
+  external_sort(first, n, key, tmpdir, memory_budget, type_c<value_type>);
+}
+
+} // namespace
+} // namespace rekt
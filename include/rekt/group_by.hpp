@@ -0,0 +1,228 @@
+/// Copyright (c) Benjamin Kietzman (github.com/bkietz)
+///
+/// Distributed under the Boost Software License, Version 1.0. (See accompanying
+/// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <functional>
+#include <limits>
+#include <rekt/columns.hpp>
+#include <rekt/detail/hash_index.hpp>
+
+namespace rekt
+{
+namespace
+{
+
+///
+/// Aggregates for grouping::aggregate(). Each has an accumulator type (given
+/// the zip::iterator of the rows being grouped), an identity value with which
+/// a new group's accumulator starts, and a call operator which folds a batch
+/// of n rows into the accumulators of their groups:
+///
+///     aggregate(rows, groups, n, accumulators) // accumulators[groups[i]] <- row i
+
+///
+/// The column's element type
+template <typename Symbol, typename Iterator>
+using aggregated_t = typename std::iterator_traits<std::decay_t<decltype(get(Symbol{}, std::declval<Iterator>()))>>::value_type;
+
+template <typename Aggregate, typename Iterator>
+using accumulator_t = typename std::decay_t<Aggregate>::template accumulator<Iterator>;
+
+template <typename Symbol>
+struct sum_t
+{
+  // integers are summed in 64 bits, since the column's own type overflows too easily
+  template <typename Iterator, typename Element = aggregated_t<Symbol, Iterator>>
+  using accumulator = std::conditional_t<std::is_integral<Element>::value,
+                                         std::conditional_t<std::is_signed<Element>::value, long long, unsigned long long>,
+                                         std::decay_t<decltype(std::declval<Element>() + std::declval<Element>())>>;
+
+  template <typename Accumulator>
+  static Accumulator identity()
+  {
+    return Accumulator{};
+  }
+
+  template <typename Iterator, typename Accumulator>
+  void operator()(Iterator rows, std::size_t const *groups, std::size_t n, Accumulator *accumulators) const
+  {
+    auto column = get(Symbol{}, rows);
+    for (std::size_t i = 0; i != n; ++i, ++column)
+    {
+      accumulators[groups[i]] += *column;
+    }
+  }
+};
+
+struct count_t
+{
+  template <typename Iterator>
+  using accumulator = std::size_t;
+
+  template <typename Accumulator>
+  static Accumulator identity()
+  {
+    return 0;
+  }
+
+  template <typename Iterator, typename Accumulator>
+  void operator()(Iterator, std::size_t const *groups, std::size_t n, Accumulator *accumulators) const
+  {
+    for (std::size_t i = 0; i != n; ++i)
+    {
+      ++accumulators[groups[i]];
+    }
+  }
+};
+
+template <typename Symbol, typename Compare>
+struct extremum_t
+{
+  // bool is accumulated as unsigned char, since the result
+  // column can't be a std::vector<bool> (which has no data())
+  template <typename Iterator, typename Element = aggregated_t<Symbol, Iterator>>
+  using accumulator = std::conditional_t<std::is_same<Element, bool>::value, unsigned char, Element>;
+
+  // anything compares at least as well as this
+  template <typename Accumulator>
+  static Accumulator identity()
+  {
+    static_assert(std::is_arithmetic<Accumulator>::value, "min() and max() aggregate only arithmetic columns");
+    using limits = std::numeric_limits<Accumulator>;
+    return Compare{}(0, 1)
+        ? (limits::has_infinity ? limits::infinity() : limits::max())
+        : (limits::has_infinity ? -limits::infinity() : limits::lowest());
+  }
+
+  template <typename Iterator, typename Accumulator>
+  void operator()(Iterator rows, std::size_t const *groups, std::size_t n, Accumulator *accumulators) const
+  {
+    auto column = get(Symbol{}, rows);
+    for (std::size_t i = 0; i != n; ++i, ++column)
+    {
+      auto &a = accumulators[groups[i]];
+      if (Compare{}(*column, a))
+      {
+        a = *column;
+      }
+    }
+  }
+};
+
+///
+/// sum of a column in each group
+template <typename Symbol>
+constexpr sum_t<Symbol> sum(Symbol const &)
+{
+  return {};
+}
+
+///
+/// number of rows in each group
+constexpr count_t count()
+{
+  return {};
+}
+
+///
+/// greatest value of an arithmetic column in each group.
+/// That of a bool column is an unsigned char, 1 if any row is true.
+template <typename Symbol>
+constexpr extremum_t<Symbol, std::greater<>> max(Symbol const &)
+{
+  return {};
+}
+
+///
+/// least value of an arithmetic column in each group.
+/// That of a bool column is an unsigned char, 1 if every row is true.
+template <typename Symbol>
+constexpr extremum_t<Symbol, std::less<>> min(Symbol const &)
+{
+  return {};
+}
+
+///
+/// The result of group_by(); see below
+template <typename Range, typename Key>
+class grouping
+{
+public:
+  /// rows are hashed into groups this many at a time, then
+  /// each aggregate folds its column over the whole batch
+  static constexpr std::size_t batch_rows = 4096;
+
+  template <typename R>
+  explicit grouping(R &&zipped)
+      : range_(std::forward<R>(zipped))
+  {
+  }
+
+  template <typename... Outputs, typename... Aggregates>
+  auto aggregate(field<Outputs, Aggregates>... aggregates)
+  {
+    auto first = range_.begin();
+    auto last = range_.end();
+    using iterator = decltype(first);
+    using key_type = std::decay_t<decltype(*get(Key{}, first))>;
+    using result_type = columns<record<field<Key, key_type>,
+                                       field<Outputs, accumulator_t<Aggregates, iterator>>...>>;
+
+    result_type result;
+    auto &keys = get(Key{}, result);
+    hash_index index;
+    std::vector<std::size_t> groups(batch_rows);
+
+    while (first != last)
+    {
+      auto batch = first;
+      std::size_t n = 0;
+      for (; n != batch_rows && first != last; ++n, ++first)
+      {
+        key_type const &k = *get(Key{}, first);
+        auto g = index.find_or_insert(std::hash<key_type>{}(k), keys.size(), [&](std::size_t other) {
+          return keys[other] == k;
+        });
+        if (g == keys.size())
+        {
+          keys.push_back(k);
+          symbol_set<Outputs...>{ (get(Outputs{}, result).push_back(aggregates.value().template identity<accumulator_t<Aggregates, iterator>>()), Outputs{})... };
+        }
+        groups[n] = g;
+      }
+      symbol_set<Outputs...>{ (aggregates.value()(batch, groups.data(), n, get(Outputs{}, result).data()), Outputs{})... };
+    }
+    return result;
+  }
+
+private:
+  zip::owned_t<Range &&> range_;
+};
+
+template <typename Range, typename Key>
+constexpr std::size_t grouping<Range, Key>::batch_rows;
+
+///
+/// Group the rows of a zip::range (or columns) by the value of one field,
+/// then compute aggregates of each group:
+///
+///     auto rollup = group_by(zip(account = accounts, price = prices), account)
+///                       .aggregate(total = sum(price), n = count(), hi = max(price));
+///     account(rollup) // std::vector of each distinct account
+///     total(rollup)   // std::vector of the sum of prices for each account
+///
+/// The result is a columns with a field for the key followed by one field
+/// for each aggregate. Groups appear in the order their keys first appear.
+/// Ranges passed as lvalues must outlive the grouping; temporaries are
+/// moved into it.
+template <typename Range, typename Key>
+auto group_by(Range &&zipped, Key const &)
+{
+  return grouping<Range, Key>{ std::forward<Range>(zipped) };
+}
+
+} // namespace
+} // namespace rekt
@@ -0,0 +1,150 @@
+/// Copyright (c) Benjamin Kietzman (github.com/bkietz)
+///
+/// Distributed under the Boost Software License, Version 1.0. (See accompanying
+/// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <rekt/detail/hash_index.hpp>
+#include <rekt/packed_record.hpp>
+#include <rekt/record.hpp>
+
+namespace rekt
+{
+namespace
+{
+
+///
+/// Fold the hash of another value into a seed. The seed is mixed and
+/// rotated first, so every earlier hash reaches the high bits hash_index
+/// uses and equal fields in a different order hash differently. (Mixing
+/// alone would leave the index multiplying by the square of its own
+/// multiplier, which clusters keys like (k, k % 7) badly.)
+constexpr std::size_t hash_combine(std::size_t seed, std::size_t h)
+{
+  std::uint64_t mixed = mix_hash(seed);
+  return static_cast<std::size_t>((mixed << 29 | mixed >> 35) ^ h);
+}
+
+///
+/// Hash only the fields of a row for some symbols, with std::hash of
+/// each field's type. Works on anything get() accepts, including the
+/// zip::reference proxies of a zip::range, so nothing is copied:
+///
+///     hash_fields(row, city, age) == hash_fields(make_record(age = 30, city = c), city, age)
+template <typename Row, typename... Symbols>
+std::size_t hash_fields(Row const &row, Symbols const &...)
+{
+  std::size_t seed = 0;
+  // symbols may repeat, so they can't make a symbol_set
+  (void)std::initializer_list<int>{ (seed = hash_combine(seed, std::hash<std::decay_t<decltype(get(Symbols{}, row))>>{}(get(Symbols{}, row))), 0)... };
+  return seed;
+}
+
+template <typename ColumnIterator>
+void hash_column(ColumnIterator column, std::size_t n, std::size_t *hashes)
+{
+  std::hash<typename std::iterator_traits<ColumnIterator>::value_type> h;
+  for (std::size_t i = 0; i != n; ++i, ++column)
+  {
+    hashes[i] = hash_combine(hashes[i], h(*column));
+  }
+}
+
+///
+/// For each of n rows from a random access zip::iterator, the same hash as
+/// hash_fields() gives. Each column is read in turn, rather than each row.
+template <typename Iterator, typename... Symbols>
+void hash_columns(Iterator rows, std::size_t n, std::size_t *hashes, Symbols const &...)
+{
+  std::fill(hashes, hashes + n, std::size_t(0));
+  (void)std::initializer_list<int>{ (hash_column(get(Symbols{}, rows), n, hashes), 0)... };
+}
+
+///
+/// Fields whose values are equal exactly when their bytes are, and which
+/// fill their record without padding, can be hashed as one run of bytes
+template <typename... Symbols, typename... Values>
+constexpr bool hashes_as_bytes(type_constant<record<field<Symbols, Values>...>>)
+{
+  return all_true({ (std::is_integral<Values>::value || std::is_enum<Values>::value || std::is_pointer<Values>::value)... }) &&
+         sizeof(record<field<Symbols, Values>...>) == sum_of({ sizeof(Values)... });
+}
+
+///
+/// Hash n bytes a word at a time with hash_combine()
+inline std::size_t hash_bytes(unsigned char const *bytes, std::size_t n)
+{
+  std::size_t seed = 0;
+  for (; n >= sizeof(std::uint64_t); bytes += sizeof(std::uint64_t), n -= sizeof(std::uint64_t))
+  {
+    std::uint64_t word;
+    std::memcpy(&word, bytes, sizeof(word));
+    seed = hash_combine(seed, static_cast<std::size_t>(word));
+  }
+  if (n != 0)
+  {
+    std::uint64_t word = 0;
+    std::memcpy(&word, bytes, n);
+    seed = hash_combine(seed, static_cast<std::size_t>(word));
+  }
+  return seed;
+}
+
+///
+/// Hashes records consistently with their operator==, so that they can
+/// key unordered containers:
+///
+///     std::unordered_map<record<field<user, int>, field<day, int>>, double, rekt::hash> visits;
+///
+/// Records of integers, enums and pointers without padding are hashed as
+/// one run of bytes, a word at a time. Others combine std::hash of each
+/// field, as hash_fields() does. Hashes of records of different types
+/// (with fields in another order, or references rather than values) are
+/// not comparable, even if the records compare equal.
+struct hash
+{
+  template <typename... Symbols, typename... Values>
+  std::size_t operator()(record<field<Symbols, Values>...> const &r) const
+  {
+    return hash_(r, integer_c<bool, hashes_as_bytes(type_c<record<field<Symbols, Values>...>>)>);
+  }
+
+private:
+  template <typename Record>
+  static std::size_t hash_(Record const &r, std::true_type /* as bytes */)
+  {
+    return hash_bytes(reinterpret_cast<unsigned char const *>(&r), sizeof(Record));
+  }
+
+  template <typename... Symbols, typename... Values>
+  static std::size_t hash_(record<field<Symbols, Values>...> const &r, std::false_type /* as bytes */)
+  {
+    return hash_fields(r, Symbols{}...);
+  }
+};
+
+} // namespace
+} // namespace rekt
+
+namespace std
+{
+
+template <typename... Symbols, typename... Values>
+struct hash<rekt::record<rekt::field<Symbols, Values>...>> : rekt::hash
+{
+};
+
+// packed_records hash (as they compare) through their storage record
+template <typename... Symbols, typename... Values>
+struct hash<rekt::packed_record<rekt::field<Symbols, Values>...>> : rekt::hash
+{
+};
+
+} // namespace std
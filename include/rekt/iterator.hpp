@@ -6,8 +6,12 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
 #include <iterator>
 #include <rekt/record.hpp>
+#include <rekt/span.hpp>
+#include <stdexcept>
+#include <vector>
 
 namespace rekt
 {
@@ -22,14 +26,53 @@ struct zip
   template <typename... Symbols, typename... ContainerRefs>
   constexpr auto operator()(field<Symbols, ContainerRefs>... container_ref_fields) const;
 
+  template <typename... Symbols, typename... ContainerRefs>
+  auto sized(field<Symbols, ContainerRefs>... container_ref_fields) const;
+
   template <typename ContainerRecord>
   class range;
 
+  template <typename ContainerRecord>
+  class sized_range;
+
+  // temporaries are owned by the zip::range, lvalues are referenced
+  template <typename ContainerRef>
+  using owned_t = std::conditional_t<std::is_rvalue_reference<ContainerRef>::value,
+                                     std::remove_reference_t<ContainerRef>,
+                                     ContainerRef>;
+
+  template <typename Container>
+  static constexpr auto size_of(Container const &c) -> decltype(c.size())
+  {
+    return c.size();
+  }
+
+  template <typename Element, std::size_t N>
+  static constexpr std::size_t size_of(Element const (&)[N])
+  {
+    return N;
+  }
+
   // catch-all tag for non-standard iterator categories
   struct iterator_tag
   {
   };
 
+  // every zipped iterator is a pointer; zip::iterators of this category
+  // keep the pointers fixed and advance a single index instead
+  struct contiguous_iterator_tag : std::random_access_iterator_tag
+  {
+  };
+
+  ///
+  /// Containers whose elements are stored contiguously are zipped
+  /// by pointer rather than by iterator. Specialize this for other
+  /// containers which provide contiguous data() and size()
+  template <typename Container>
+  struct contiguous : std::false_type
+  {
+  };
+
   static constexpr auto iterator_category_ordering = make_record(
       // satisfies Iterator, but not InputIterator or OutputIterator
       make_field(iterator_tag{}, index_c<0>),
@@ -55,25 +98,71 @@ struct zip
   template <typename IteratorRecord>
   struct reference;
 
+  template <typename Iterator>
+  class counted_iterator;
+
+  template <typename IteratorRecord>
+  class chunk_range;
+
   struct begin
   {
     template <typename Symbol, typename Container>
     constexpr auto operator()(Symbol const &, Container &&c) const
+    {
+      return impl(contiguous<std::decay_t<Container>>{}, std::forward<Container>(c));
+    }
+
+    template <typename Container>
+    static constexpr auto impl(std::false_type, Container &&c)
     {
       return std::begin(std::forward<Container>(c));
     }
+
+    template <typename Container>
+    static constexpr auto impl(std::true_type, Container &&c)
+    {
+      return c.data();
+    }
   };
 
   struct end
   {
     template <typename Symbol, typename Container>
     constexpr auto operator()(Symbol const &, Container &&c) const
+    {
+      return impl(contiguous<std::decay_t<Container>>{}, std::forward<Container>(c));
+    }
+
+    template <typename Container>
+    static constexpr auto impl(std::false_type, Container &&c)
     {
       return std::end(std::forward<Container>(c));
     }
+
+    template <typename Container>
+    static constexpr auto impl(std::true_type, Container &&c)
+    {
+      return c.data() + c.size();
+    }
   };
 };
 
+template <typename Element, typename Allocator>
+struct zip::contiguous<std::vector<Element, Allocator>> : std::true_type
+{
+};
+
+// no pointers to bits
+template <typename Allocator>
+struct zip::contiguous<std::vector<bool, Allocator>> : std::false_type
+{
+};
+
+template <typename Element, std::size_t N>
+struct zip::contiguous<std::array<Element, N>> : std::true_type
+{
+};
+
 template <typename... Symbols, typename... Containers>
 class zip::range<record<field<Symbols, Containers>...>>
     : public record<field<Symbols, Containers>...>
@@ -94,13 +183,76 @@ public:
 
   iterator begin()
   {
-    return iterator{ map(*this, zip::begin{}) };
+    return begin_(iterator_category{});
   }
 
   iterator end()
+  {
+    return end_(iterator_category{});
+  }
+
+  ///
+  /// the length of the shortest zipped container
+  std::size_t size() const
+  {
+    return std::min({ static_cast<std::size_t>(zip::size_of(get(Symbols{}, *this)))... });
+  }
+
+  bool empty() const
+  {
+    return size() == 0;
+  }
+
+  ///
+  /// View a contiguous range as consecutive chunks of n rows (the last
+  /// may be shorter). Each chunk is a record of spans, one per column.
+  ///
+  ///     for (auto chunk : zip(a = as, b = bs).chunks(1024))
+  ///       kernel(a(chunk).data(), b(chunk).data(), a(chunk).size());
+  ///
+  /// Chunks point into the containers, so they must not outlive them. A
+  /// range which owns its containers (zipped from temporaries) can only
+  /// be chunked as an lvalue.
+  zip::chunk_range<iterator_record> chunks(std::size_t n) &
+  {
+    static_assert(std::is_same<iterator_category, zip::contiguous_iterator_tag>::value,
+                  "only contiguous ranges can be viewed as chunks");
+    auto first = begin();
+    return zip::chunk_range<iterator_record>{ first.bases(), static_cast<std::size_t>(end() - first), n };
+  }
+
+  zip::chunk_range<iterator_record> chunks(std::size_t n) &&
+  {
+    static_assert(all_true({ std::is_reference<Containers>::value... }),
+                  "chunks of a temporary range which owns its containers would dangle");
+    return chunks(n);
+  }
+
+private:
+  template <typename Category>
+  iterator begin_(Category)
+  {
+    return iterator{ map(*this, zip::begin{}) };
+  }
+
+  template <typename Category>
+  iterator end_(Category)
   {
     return iterator{ map(*this, zip::end{}) };
   }
+
+  iterator begin_(zip::contiguous_iterator_tag)
+  {
+    return iterator{ map(*this, zip::begin{}), 0 };
+  }
+
+  // the shortest sequence determines the length of the range
+  iterator end_(zip::contiguous_iterator_tag)
+  {
+    auto begins = map(*this, zip::begin{});
+    auto ends = map(*this, zip::end{});
+    return iterator{ begins, std::min({ get(Symbols{}, ends) - get(Symbols{}, begins)... }) };
+  }
 };
 
 template <typename Iterator>
@@ -153,9 +305,13 @@ struct zip::iterator_category<record<field<Symbols, Iterators>...>>
     return get(index_c<N>, reverse);
   }
 
-  constexpr static auto minimum_iterator_category_ord = index_c<std::min({ iterator_category_ordering_v<typename iterator_category<Iterators>::type>... })>;
+  constexpr static auto minimum_iterator_category_ord = index_c<std::min({ std::size_t(iterator_category_ordering_v<typename iterator_category<Iterators>::type>)... })>;
+
+  constexpr static bool all_pointers = std::min({ std::is_pointer<Iterators>::value... });
 
-  using type = decltype(impl(minimum_iterator_category_ord));
+  using type = std::conditional_t<all_pointers,
+                                  zip::contiguous_iterator_tag,
+                                  decltype(impl(minimum_iterator_category_ord))>;
 };
 
 template <typename... Symbols, typename... Iterators>
@@ -179,10 +335,64 @@ public:
   reference &operator=(reference &&) = default;
 
   using value_type = record<field<Symbols, typename std::iterator_traits<Iterators>::value_type>...>;
-  operator value_type()
+
+  ///
+  /// copies the referenced elements. std::sort and friends materialize
+  /// value_types this way too (std::move(*it) is still a zip::reference),
+  /// so they copy expensive fields and can't sort move only ones; use
+  /// sort_by(), which moves each column through a permutation, instead.
+  operator value_type() const
   {
     return map(*this, [](auto &&, auto &&v) { return v; });
   }
+
+  ///
+  /// materialize a value_type by moving from the referenced elements.
+  /// Conversion always copies, since operator* returns references as
+  /// prvalues and reads like value_type v = *it must not empty the range.
+  friend value_type iter_move(reference r)
+  {
+    return map(std::move(r), [](auto &&, auto &&v) { return std::move(v); });
+  }
+
+  ///
+  /// swap referenced elements in place, one field at a time;
+  /// no value_type is materialized
+  void swap(reference &other)
+  {
+    symbol_set<Symbols...>{ (swap_field_<Iterators>(get(Symbols{}, *this), get(Symbols{}, other)), Symbols{})... };
+  }
+
+  // found by ADL, so zipped pointers (whose associated namespaces
+  // needn't include std) can be swapped too
+  friend void swap(reference l, reference r)
+  {
+    l.swap(r);
+  }
+
+private:
+  template <typename Iterator, typename Element>
+  static void swap_field_(Element &l, Element &r)
+  {
+    swap_field_<Iterator>(l, r, std::is_reference<typename std::iterator_traits<Iterator>::reference>{});
+  }
+
+  template <typename Iterator, typename Element>
+  static void swap_field_(Element &l, Element &r, std::true_type)
+  {
+    using std::swap;
+    swap(l, r);
+  }
+
+  // proxy references (like std::vector<bool>'s) are assigned through,
+  // since swapping the proxies themselves would not touch the elements
+  template <typename Iterator, typename Proxy>
+  static void swap_field_(Proxy &l, Proxy &r, std::false_type)
+  {
+    typename std::iterator_traits<Iterator>::value_type tmp = std::move(l);
+    l = std::move(r);
+    r = std::move(tmp);
+  }
 };
 
 template <typename... Symbols, typename... Iterators>
@@ -431,22 +641,491 @@ zip::iterator<std::random_access_iterator_tag, I> operator+(typename zip::iterat
   return i + n;
 }
 
+///
+/// Since all zipped sequences are contiguous, a single index locates an
+/// element in each of them; only the index moves when iterating.
+/// Increments, comparisons, and differences each touch one integer.
+template <typename... Symbols, typename... Pointers>
+class zip::iterator<zip::contiguous_iterator_tag, record<field<Symbols, Pointers>...>>
+{
+public:
+  using iterator_record = record<field<Symbols, Pointers>...>;
+
+  // std::iterator_traits
+  using iterator_category = std::random_access_iterator_tag;
+  using reference = zip::reference<iterator_record>;
+  using value_type = typename reference::value_type;
+  using pointer = reference *;
+  using difference_type = std::ptrdiff_t;
+
+  constexpr iterator() = default;
+
+  constexpr iterator(iterator_record bases, difference_type i)
+      : bases_{ bases }, i_{ i }
+  {
+  }
+
+  ///
+  /// the record of pointers from which this iterator is offset
+  constexpr iterator_record const &bases() const
+  {
+    return bases_;
+  }
+
+  constexpr difference_type index() const
+  {
+    return i_;
+  }
+
+  template <typename Symbol>
+  friend constexpr auto get(Symbol const &s, iterator const &it)
+      -> decltype(get(s, it.bases()) + it.index())
+  {
+    return get(s, it.bases()) + it.index();
+  }
+
+  reference operator*() const
+  {
+    return reference{ *this };
+  }
+
+  reference operator[](difference_type n) const
+  {
+    return reference{ *this + n };
+  }
+
+  iterator &operator++()
+  {
+    ++i_;
+    return *this;
+  }
+
+  iterator operator++(int)
+  {
+    auto copy = *this;
+    ++i_;
+    return copy;
+  }
+
+  iterator &operator--()
+  {
+    --i_;
+    return *this;
+  }
+
+  iterator operator--(int)
+  {
+    auto copy = *this;
+    --i_;
+    return copy;
+  }
+
+  iterator &operator+=(difference_type n)
+  {
+    i_ += n;
+    return *this;
+  }
+
+  iterator &operator-=(difference_type n)
+  {
+    i_ -= n;
+    return *this;
+  }
+
+  iterator operator+(difference_type n) const
+  {
+    return iterator{ bases_, i_ + n };
+  }
+
+  friend iterator operator+(difference_type n, iterator const &it)
+  {
+    return it + n;
+  }
+
+  iterator operator-(difference_type n) const
+  {
+    return iterator{ bases_, i_ - n };
+  }
+
+  // NB: only iterators into the same zip::range may be compared or subtracted
+  difference_type operator-(iterator const &other) const
+  {
+    return i_ - other.i_;
+  }
+
+  friend bool operator==(iterator const &l, iterator const &r)
+  {
+    return l.i_ == r.i_;
+  }
+
+  friend bool operator!=(iterator const &l, iterator const &r)
+  {
+    return l.i_ != r.i_;
+  }
+
+  bool operator<(iterator const &other) const
+  {
+    return i_ < other.i_;
+  }
+
+  bool operator<=(iterator const &other) const
+  {
+    return i_ <= other.i_;
+  }
+
+  bool operator>(iterator const &other) const
+  {
+    return i_ > other.i_;
+  }
+
+  bool operator>=(iterator const &other) const
+  {
+    return i_ >= other.i_;
+  }
+
+private:
+  iterator_record bases_;
+  difference_type i_ = 0;
+};
+
+///
+/// The chunks of a contiguous zip::range; see zip::range::chunks()
+template <typename... Symbols, typename... Pointers>
+class zip::chunk_range<record<field<Symbols, Pointers>...>>
+{
+public:
+  using value_type = record<field<Symbols, span<std::remove_pointer_t<Pointers>>>...>;
+  using bases_record = record<field<Symbols, Pointers>...>;
+
+  class iterator;
+
+  ///
+  /// throws std::invalid_argument if chunk_rows is 0
+  chunk_range(bases_record bases, std::size_t rows, std::size_t chunk_rows)
+      : bases_{ bases }, rows_{ rows }, chunk_rows_{ chunk_rows }
+  {
+    if (chunk_rows == 0)
+    {
+      throw std::invalid_argument("zip::range::chunks(): chunks must have at least one row");
+    }
+  }
+
+  ///
+  /// the number of chunks
+  std::size_t size() const
+  {
+    return (rows_ + chunk_rows_ - 1) / chunk_rows_;
+  }
+
+  bool empty() const
+  {
+    return rows_ == 0;
+  }
+
+  value_type operator[](std::size_t i) const
+  {
+    auto offset = i * chunk_rows_;
+    auto length = std::min(chunk_rows_, rows_ - offset);
+    return value_type{ span<std::remove_pointer_t<Pointers>>{ get(Symbols{}, bases_) + offset, length }... };
+  }
+
+  iterator begin() const
+  {
+    return iterator{ *this, 0 };
+  }
+
+  iterator end() const
+  {
+    return iterator{ *this, size() };
+  }
+
+private:
+  bases_record bases_;
+  std::size_t rows_, chunk_rows_;
+};
+
+template <typename... Symbols, typename... Pointers>
+class zip::chunk_range<record<field<Symbols, Pointers>...>>::iterator
+{
+public:
+  // chunks are produced by value
+  using iterator_category = std::input_iterator_tag;
+  using value_type = typename chunk_range::value_type;
+  using reference = value_type;
+  using pointer = value_type *;
+  using difference_type = std::ptrdiff_t;
+
+  iterator(chunk_range const &chunks, std::size_t i)
+      : chunks_{ chunks }, i_{ i }
+  {
+  }
+
+  value_type operator*() const
+  {
+    return chunks_[i_];
+  }
+
+  iterator &operator++()
+  {
+    ++i_;
+    return *this;
+  }
+
+  iterator operator++(int)
+  {
+    auto copy = *this;
+    ++i_;
+    return copy;
+  }
+
+  friend bool operator==(iterator const &l, iterator const &r)
+  {
+    return l.i_ == r.i_;
+  }
+
+  friend bool operator!=(iterator const &l, iterator const &r)
+  {
+    return l.i_ != r.i_;
+  }
+
+private:
+  chunk_range chunks_;
+  std::size_t i_;
+};
+
+///
+/// Wraps a zip::iterator with a count of its position, so iterators are compared
+/// and subtracted by that count alone rather than by every zipped iterator.
+template <typename Iterator>
+class zip::counted_iterator
+{
+public:
+  using iterator_category = typename Iterator::iterator_category;
+  using reference = typename Iterator::reference;
+  using value_type = typename Iterator::value_type;
+  using pointer = typename Iterator::pointer;
+  using difference_type = typename Iterator::difference_type;
+
+  constexpr counted_iterator(Iterator it, difference_type n)
+      : it_{ it }, n_{ n }
+  {
+  }
+
+  constexpr Iterator const &base() const
+  {
+    return it_;
+  }
+
+  constexpr difference_type count() const
+  {
+    return n_;
+  }
+
+  template <typename Symbol>
+  friend constexpr auto get(Symbol const &s, counted_iterator const &it)
+      -> decltype(get(s, it.base()))
+  {
+    return get(s, it.base());
+  }
+
+  reference operator*() const
+  {
+    return *it_;
+  }
+
+  reference operator[](difference_type n) const
+  {
+    return *(*this + n);
+  }
+
+  counted_iterator &operator++()
+  {
+    ++it_;
+    ++n_;
+    return *this;
+  }
+
+  counted_iterator operator++(int)
+  {
+    auto copy = *this;
+    ++*this;
+    return copy;
+  }
+
+  counted_iterator &operator--()
+  {
+    --it_;
+    --n_;
+    return *this;
+  }
+
+  counted_iterator operator--(int)
+  {
+    auto copy = *this;
+    --*this;
+    return copy;
+  }
+
+  counted_iterator &operator+=(difference_type n)
+  {
+    it_ += n;
+    n_ += n;
+    return *this;
+  }
+
+  counted_iterator &operator-=(difference_type n)
+  {
+    return *this += (-n);
+  }
+
+  counted_iterator operator+(difference_type n) const
+  {
+    auto copy = *this;
+    copy += n;
+    return copy;
+  }
+
+  friend counted_iterator operator+(difference_type n, counted_iterator const &it)
+  {
+    return it + n;
+  }
+
+  counted_iterator operator-(difference_type n) const
+  {
+    return *this + (-n);
+  }
+
+  difference_type operator-(counted_iterator const &other) const
+  {
+    return n_ - other.n_;
+  }
+
+  friend bool operator==(counted_iterator const &l, counted_iterator const &r)
+  {
+    return l.n_ == r.n_;
+  }
+
+  friend bool operator!=(counted_iterator const &l, counted_iterator const &r)
+  {
+    return l.n_ != r.n_;
+  }
+
+  bool operator<(counted_iterator const &other) const
+  {
+    return n_ < other.n_;
+  }
+
+  bool operator<=(counted_iterator const &other) const
+  {
+    return n_ <= other.n_;
+  }
+
+  bool operator>(counted_iterator const &other) const
+  {
+    return n_ > other.n_;
+  }
+
+  bool operator>=(counted_iterator const &other) const
+  {
+    return n_ >= other.n_;
+  }
+
+private:
+  Iterator it_;
+  difference_type n_;
+};
+
+///
+/// A zip::range whose containers are required to have the same length.
+/// That length is checked and stored when the range is constructed;
+/// ending iteration checks only a single counter.
+/// Containers must provide size() (or be bare arrays).
+///
+/// NB: the stored length is not updated if the containers are resized
+template <typename... Symbols, typename... Containers>
+class zip::sized_range<record<field<Symbols, Containers>...>>
+    : public zip::range<record<field<Symbols, Containers>...>>
+{
+public:
+  using unsized_range = zip::range<record<field<Symbols, Containers>...>>;
+  using iterator_category = typename unsized_range::iterator_category;
+
+  // contiguous iterators already compare a single index
+  using iterator = std::conditional_t<std::is_same<iterator_category, zip::contiguous_iterator_tag>::value,
+                                      typename unsized_range::iterator,
+                                      zip::counted_iterator<typename unsized_range::iterator>>;
+
+  ///
+  /// throws std::length_error if the containers have different lengths
+  sized_range(rekt::field<Symbols, Containers>... container_ref_fields)
+      : unsized_range{ std::move(container_ref_fields)... }, size_{ unsized_range::size() }
+  {
+    std::size_t sizes[] = { static_cast<std::size_t>(zip::size_of(get(Symbols{}, *this)))... };
+    if (std::find_if(std::begin(sizes), std::end(sizes), [this](std::size_t s) { return s != size_; }) != std::end(sizes))
+    {
+      throw std::length_error("zip.sized(): containers have different lengths");
+    }
+  }
+
+  iterator begin()
+  {
+    return make_iterator_(unsized_range::begin(), 0, iterator_category{});
+  }
+
+  iterator end()
+  {
+    return make_iterator_(unsized_range::end(), static_cast<std::ptrdiff_t>(size_), iterator_category{});
+  }
+
+  std::size_t size() const
+  {
+    return size_;
+  }
+
+  bool empty() const
+  {
+    return size_ == 0;
+  }
+
+private:
+  template <typename Category>
+  static iterator make_iterator_(typename unsized_range::iterator it, std::ptrdiff_t n, Category)
+  {
+    return iterator{ it, n };
+  }
+
+  static iterator make_iterator_(typename unsized_range::iterator it, std::ptrdiff_t, zip::contiguous_iterator_tag)
+  {
+    return it;
+  }
+
+  std::size_t size_;
+};
+
+///
+/// Containers passed as lvalues are referenced by the zip::range; temporaries
+/// are moved into it and owned by it, so they live as long as the range does.
+///
+///     auto zipped = zip(a = as, b = std::vector<int>(as.size()));
+///     b(zipped) // std::vector<int>& owned by zipped
+///
+/// NB: iterators into an owned std::array are invalidated if the range is moved
 template <typename... Symbols, typename... ContainerRefs>
 constexpr auto zip::operator()(field<Symbols, ContainerRefs>... container_ref_fields) const
 {
-  // We need this so we can zip temporaries too
-  // test with bare arrays too
-  //using container_record = record<field<Symbols,
-  //  std::conditional_t<std::is_rvalue_reference<ContainerRefs>::value,
-  //    std::remove_reference_t<ContainerRefs>,
-  //    ContainerRefs>
-  //  >...
-  //>;
-  //
-  static_assert(std::min({ std::is_lvalue_reference<ContainerRefs>::value... }),
-                "zipping temporaries not currently supported");
-  using container_record = record<field<Symbols, ContainerRefs>...>;
-  return zip::range<container_record>{ std::move(container_ref_fields)... };
+  using container_record = record<field<Symbols, owned_t<ContainerRefs>>...>;
+  return zip::range<container_record>{ container_ref_fields.value()... };
+}
+
+///
+/// Like zip(), but the containers must all have the same length:
+///
+///     for (auto r : zip.sized(a = as, b = bs)) // throws if as.size() != bs.size()
+template <typename... Symbols, typename... ContainerRefs>
+auto zip::sized(field<Symbols, ContainerRefs>... container_ref_fields) const
+{
+  using container_record = record<field<Symbols, owned_t<ContainerRefs>>...>;
+  return zip::sized_range<container_record>{ container_ref_fields.value()... };
 }
 
 constexpr struct zip zip = {};
@@ -460,10 +1139,7 @@ namespace std
 template <typename I>
 void swap(rekt::zip::reference<I> l, rekt::zip::reference<I> r)
 {
-  using value_type = typename rekt::zip::reference<I>::value_type;
-  value_type tmp{ std::move(l) };
-  l = std::move(r);
-  r = std::move(tmp);
+  l.swap(r);
 }
 
 template <typename C, typename I>
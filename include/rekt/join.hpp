@@ -0,0 +1,380 @@
+/// Copyright (c) Benjamin Kietzman (github.com/bkietz)
+///
+/// Distributed under the Boost Software License, Version 1.0. (See accompanying
+/// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <rekt/detail/hash_index.hpp>
+#include <rekt/iterator.hpp>
+
+namespace rekt
+{
+namespace
+{
+
+///
+/// The rows of a hash_join(); see below
+template <typename Left, typename Right, typename Symbol>
+class hash_join_range
+{
+  using left_iterator = decltype(std::declval<std::remove_reference_t<Left> &>().begin());
+  using right_iterator = decltype(std::declval<std::remove_reference_t<Right> &>().begin());
+  using left_key = std::decay_t<decltype(*get(Symbol{}, std::declval<left_iterator>()))>;
+  using right_key = std::decay_t<decltype(*get(Symbol{}, std::declval<right_iterator>()))>;
+  using key_type = std::common_type_t<left_key, right_key>;
+
+  static_assert(std::is_base_of<std::random_access_iterator_tag, typename std::iterator_traits<right_iterator>::iterator_category>::value,
+                "the right (build) side of hash_join must be random access");
+
+public:
+  using reference = merged_records<typename std::iterator_traits<left_iterator>::reference,
+                                   typename std::iterator_traits<right_iterator>::reference>;
+
+  class iterator;
+
+  template <typename L, typename R>
+  hash_join_range(L &&left, R &&right)
+      : left_(std::forward<L>(left)), right_(std::forward<R>(right))
+  {
+    auto keys = get(Symbol{}, right_.begin());
+    auto rows = static_cast<std::size_t>(right_.end() - right_.begin());
+    index_ = hash_index{ rows };
+    for (std::size_t row = 0; row != rows; ++row)
+    {
+      key_type const &k = keys[static_cast<std::ptrdiff_t>(row)];
+      index_.insert(hash_(k), row, [&](std::size_t other) {
+        return keys[static_cast<std::ptrdiff_t>(other)] == k;
+      });
+    }
+  }
+
+  iterator begin()
+  {
+    return iterator{ *this, left_.begin() };
+  }
+
+  iterator end()
+  {
+    return iterator{ *this, left_.end() };
+  }
+
+private:
+  static std::size_t hash_(key_type const &k)
+  {
+    return std::hash<key_type>{}(k);
+  }
+
+  // the first row on the right whose key matches this row on the left
+  std::size_t find_(left_iterator const &row, right_iterator const &right) const
+  {
+    key_type const &k = *get(Symbol{}, row);
+    auto keys = get(Symbol{}, right);
+    return index_.find(hash_(k), [&](std::size_t other) {
+      return keys[static_cast<std::ptrdiff_t>(other)] == k;
+    });
+  }
+
+  zip::owned_t<Left &&> left_;
+  zip::owned_t<Right &&> right_;
+  hash_index index_;
+};
+
+///
+/// Visits each row on the left, then each matching row on the right
+template <typename Left, typename Right, typename Symbol>
+class hash_join_range<Left, Right, Symbol>::iterator
+{
+public:
+  using iterator_category = std::input_iterator_tag;
+  using value_type = typename hash_join_range::reference;
+  using reference = value_type;
+  using pointer = value_type *;
+  using difference_type = std::ptrdiff_t;
+
+  iterator(hash_join_range &join, left_iterator left)
+      : join_{ &join }, left_{ left }, left_end_{ join.left_.end() }, right_{ join.right_.begin() }
+  {
+    settle_();
+  }
+
+  reference operator*() const
+  {
+    return reference{ *left_, right_[static_cast<std::ptrdiff_t>(match_)] };
+  }
+
+  iterator &operator++()
+  {
+    match_ = join_->index_.next(match_);
+    if (match_ == hash_index::npos)
+    {
+      ++left_;
+      settle_();
+    }
+    return *this;
+  }
+
+  iterator operator++(int)
+  {
+    auto copy = *this;
+    ++*this;
+    return copy;
+  }
+
+  friend bool operator==(iterator const &l, iterator const &r)
+  {
+    return l.left_ == r.left_ && l.match_ == r.match_;
+  }
+
+  friend bool operator!=(iterator const &l, iterator const &r)
+  {
+    return !(l == r);
+  }
+
+private:
+  // advance to the next row on the left with a match (if any)
+  void settle_()
+  {
+    for (; left_ != left_end_; ++left_)
+    {
+      match_ = join_->find_(left_, right_);
+      if (match_ != hash_index::npos)
+      {
+        return;
+      }
+    }
+    match_ = hash_index::npos;
+  }
+
+  hash_join_range *join_;
+  left_iterator left_, left_end_;
+  right_iterator right_;
+  std::size_t match_ = hash_index::npos;
+};
+
+///
+/// Inner equijoin of two zip::ranges (or columns) on a symbol they share:
+///
+///     for (auto row : hash_join(zip(id = ids, price = prices), zip(id = ids2, qty = qtys), id))
+///       total += price(row) * qty(row);
+///
+/// Each joined row is a merged_records of a row from each side, so fields
+/// defined on both sides (id, at least) are taken from the left.
+/// A hash table of the right side's keys is built immediately; the left
+/// side is probed lazily, one row at a time as the join is iterated.
+/// Rows are produced in the left's order and, for each left row, in the
+/// order of its matches on the right, so the smaller range should usually
+/// go on the right.
+///
+/// The right range must be random access. Ranges passed as lvalues must
+/// outlive the join; temporaries are moved into it.
+template <typename Left, typename Right, typename Symbol>
+auto hash_join(Left &&left, Right &&right, Symbol const &)
+{
+  return hash_join_range<Left, Right, Symbol>{ std::forward<Left>(left), std::forward<Right>(right) };
+}
+
+///
+/// The first position in [first, last) of sorted keys at which keys[i] < value
+/// is false (if after is false) or value < keys[i] is false (if after is true).
+/// Probes at exponentially increasing distances from first before binary
+/// searching, so finding a position d steps away takes O(log d) comparisons.
+template <typename KeyIterator, typename Value>
+std::size_t gallop(KeyIterator keys, std::size_t first, std::size_t last, Value const &value, bool after)
+{
+  auto before = [&](std::size_t i) {
+    auto const &k = keys[static_cast<std::ptrdiff_t>(i)];
+    return after ? !(value < k) : k < value;
+  };
+
+  std::size_t step = 1;
+  auto low = first;
+  while (low != last && before(low))
+  {
+    first = low + 1;
+    low = last - low > step ? low + step : last;
+    step *= 2;
+  }
+  // keys before first are before value, and the key at low (if any) isn't
+  while (first != low)
+  {
+    auto middle = first + (low - first) / 2;
+    if (before(middle))
+    {
+      first = middle + 1;
+    }
+    else
+    {
+      low = middle;
+    }
+  }
+  return first;
+}
+
+///
+/// The rows of a merge_join(); see below
+template <typename Left, typename Right, typename Symbol>
+class merge_join_range
+{
+  using left_iterator = decltype(std::declval<std::remove_reference_t<Left> &>().begin());
+  using right_iterator = decltype(std::declval<std::remove_reference_t<Right> &>().begin());
+
+  static_assert(std::is_base_of<std::random_access_iterator_tag, typename std::iterator_traits<left_iterator>::iterator_category>::value &&
+                    std::is_base_of<std::random_access_iterator_tag, typename std::iterator_traits<right_iterator>::iterator_category>::value,
+                "both sides of merge_join must be random access");
+
+public:
+  using reference = merged_records<typename std::iterator_traits<left_iterator>::reference,
+                                   typename std::iterator_traits<right_iterator>::reference>;
+
+  class iterator;
+
+  template <typename L, typename R>
+  merge_join_range(L &&left, R &&right)
+      : left_(std::forward<L>(left)), right_(std::forward<R>(right))
+  {
+  }
+
+  iterator begin()
+  {
+    return iterator{ left_.begin(), left_.end(), right_.begin(), right_.end(), false };
+  }
+
+  iterator end()
+  {
+    return iterator{ left_.begin(), left_.end(), right_.begin(), right_.end(), true };
+  }
+
+private:
+  zip::owned_t<Left &&> left_;
+  zip::owned_t<Right &&> right_;
+};
+
+///
+/// For each run of equal keys present on both sides, visits each
+/// row of the left run with each row of the right run
+template <typename Left, typename Right, typename Symbol>
+class merge_join_range<Left, Right, Symbol>::iterator
+{
+public:
+  using iterator_category = std::input_iterator_tag;
+  using value_type = typename merge_join_range::reference;
+  using reference = value_type;
+  using pointer = value_type *;
+  using difference_type = std::ptrdiff_t;
+
+  iterator(left_iterator left, left_iterator left_end, right_iterator right, right_iterator right_end, bool end)
+      : left_{ left }, right_{ right },
+        left_rows_{ static_cast<std::size_t>(left_end - left) }, right_rows_{ static_cast<std::size_t>(right_end - right) }
+  {
+    if (end)
+    {
+      l_ = left_rows_;
+      r_ = right_rows_;
+    }
+    else
+    {
+      settle_(0, 0);
+    }
+  }
+
+  reference operator*() const
+  {
+    return reference{ left_[static_cast<std::ptrdiff_t>(l_)], right_[static_cast<std::ptrdiff_t>(r_)] };
+  }
+
+  iterator &operator++()
+  {
+    if (++r_ != right_run_end_)
+    {
+      return *this;
+    }
+    r_ = right_run_;
+    if (++l_ != left_run_end_)
+    {
+      return *this;
+    }
+    settle_(left_run_end_, right_run_end_);
+    return *this;
+  }
+
+  iterator operator++(int)
+  {
+    auto copy = *this;
+    ++*this;
+    return copy;
+  }
+
+  friend bool operator==(iterator const &l, iterator const &r)
+  {
+    return l.l_ == r.l_ && l.r_ == r.r_;
+  }
+
+  friend bool operator!=(iterator const &l, iterator const &r)
+  {
+    return !(l == r);
+  }
+
+private:
+  // find the next key present on both sides, starting from rows l and r
+  void settle_(std::size_t l, std::size_t r)
+  {
+    auto left_keys = get(Symbol{}, left_);
+    auto right_keys = get(Symbol{}, right_);
+    while (l != left_rows_ && r != right_rows_)
+    {
+      auto const &lk = left_keys[static_cast<std::ptrdiff_t>(l)];
+      auto const &rk = right_keys[static_cast<std::ptrdiff_t>(r)];
+      if (lk < rk)
+      {
+        l = gallop(left_keys, l + 1, left_rows_, rk, false);
+      }
+      else if (rk < lk)
+      {
+        r = gallop(right_keys, r + 1, right_rows_, lk, false);
+      }
+      else
+      {
+        l_ = left_run_ = l;
+        r_ = right_run_ = r;
+        left_run_end_ = gallop(left_keys, l + 1, left_rows_, lk, true);
+        right_run_end_ = gallop(right_keys, r + 1, right_rows_, lk, true);
+        return;
+      }
+    }
+    l_ = left_rows_;
+    r_ = right_rows_;
+  }
+
+  left_iterator left_;
+  right_iterator right_;
+  std::size_t left_rows_, right_rows_;
+  // the current pair of rows, and the runs of equal keys they're in
+  std::size_t l_, r_, left_run_ = 0, left_run_end_ = 0, right_run_ = 0, right_run_end_ = 0;
+};
+
+///
+/// Inner equijoin of two random access zip::ranges (or columns) which are
+/// both sorted by a symbol they share:
+///
+///     for (auto row : merge_join(zip(id = ids, price = prices), zip(id = ids2, qty = qtys), id))
+///       total += price(row) * qty(row);
+///
+/// Rows are produced lazily in one pass over both sides, without building
+/// any table. Where keys on one side have no match on the other, the
+/// join gallops past them rather than stepping one row at a time.
+/// Joined rows are merged_records, as for hash_join(), and are produced
+/// in key order and then in the order of each side's rows.
+///
+/// Keys are compared with <. Ranges passed as lvalues must outlive the
+/// join; temporaries are moved into it.
+template <typename Left, typename Right, typename Symbol>
+auto merge_join(Left &&left, Right &&right, Symbol const &)
+{
+  return merge_join_range<Left, Right, Symbol>{ std::forward<Left>(left), std::forward<Right>(right) };
+}
+
+} // namespace
+} // namespace rekt
@@ -0,0 +1,194 @@
+/// Copyright (c) Benjamin Kietzman (github.com/bkietz)
+///
+/// Distributed under the Boost Software License, Version 1.0. (See accompanying
+/// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <rekt/introspection.hpp>
+#include <rekt/record.hpp>
+#include <tuple>
+
+namespace rekt
+{
+namespace
+{
+
+///
+/// References are stored as pointers
+template <typename Value>
+using stored_t = std::conditional_t<std::is_reference<Value>::value, void *, Value>;
+
+///
+/// The order in which packed_record stores fields: most aligned first,
+/// then largest first, then in declaration order. Every field then
+/// starts at an offset which is already a multiple of its alignment, so
+/// the only padding left is at the end, up to the record's alignment.
+template <typename... Values>
+struct packed_layout
+{
+  static constexpr std::size_t aligns[] = { alignof(stored_t<Values>)... };
+  static constexpr std::size_t sizes[] = { sizeof(stored_t<Values>)... };
+
+  static constexpr bool before(std::size_t l, std::size_t r)
+  {
+    return aligns[l] != aligns[r] ? aligns[l] > aligns[r] : sizes[l] != sizes[r] ? sizes[l] > sizes[r] : l < r;
+  }
+
+  ///
+  /// the position at which the field declared at index i is stored
+  static constexpr std::size_t position_of(std::size_t i)
+  {
+    std::size_t position = 0;
+    for (std::size_t j = 0; j != sizeof...(Values); ++j)
+    {
+      position += before(j, i);
+    }
+    return position;
+  }
+
+  ///
+  /// the declaration index of the field stored at a position
+  static constexpr std::size_t index_at(std::size_t position)
+  {
+    std::size_t i = 0;
+    while (position_of(i) != position)
+    {
+      ++i;
+    }
+    return i;
+  }
+};
+
+template <typename... Values>
+constexpr std::size_t packed_layout<Values...>::aligns[];
+
+template <typename... Values>
+constexpr std::size_t packed_layout<Values...>::sizes[];
+
+template <typename Layout, std::size_t... Position>
+index_sequence<Layout::index_at(Position)...> packed_order(index_sequence<Position...>);
+
+template <typename Fields, typename Order>
+struct packed_storage;
+
+template <typename... Fields, std::size_t... I>
+struct packed_storage<type_sequence<Fields...>, index_sequence<I...>>
+{
+  using type = record<std::tuple_element_t<I, std::tuple<Fields...>>...>;
+};
+
+template <typename... Fields>
+class packed_record;
+
+///
+/// A record whose fields are stored in the order that wastes the least
+/// space on padding, rather than in the order they were declared:
+///
+///     sizeof(make_record(flag = true, id = 1ull, ok = false, x = 1.0))        // 32
+///     sizeof(make_packed_record(flag = true, id = 1ull, ok = false, x = 1.0)) // 24
+///
+/// Storage order is an implementation detail. Everything else sees the
+/// declaration order: constructors, field_enum, map() and the ordering
+/// operators. get() and field access by symbol work as for any record.
+template <typename... Symbols, typename... Values>
+class packed_record<field<Symbols, Values>...>
+    : public packed_storage<type_sequence<field<Symbols, Values>...>,
+                            decltype(packed_order<packed_layout<Values...>>(index_sequence_for<Values...>{}))>::type
+{
+public:
+  using order = decltype(packed_order<packed_layout<Values...>>(index_sequence_for<Values...>{}));
+  using storage_record = typename packed_storage<type_sequence<field<Symbols, Values>...>, order>::type;
+  using storage_record::operator=;
+
+  constexpr packed_record() = default;
+
+  constexpr packed_record(Values... args)
+      : packed_record(std::forward_as_tuple(static_cast<Values &&>(args)...), order{})
+  {
+  }
+
+  constexpr packed_record(field<Symbols, Values>... fields)
+      : packed_record(std::forward_as_tuple(static_cast<Values &&>(fields.value())...), order{})
+  {
+  }
+
+private:
+  // the storage record takes its values in storage order
+  template <typename Tuple, std::size_t... I>
+  constexpr packed_record(Tuple &&values, index_sequence<I...>)
+      : storage_record{ static_cast<std::tuple_element_t<I, std::tuple<Values...>> &&>(std::get<I>(values))... }
+  {
+  }
+};
+
+template <>
+class packed_record<> : public record<>
+{
+};
+
+///
+/// Like make_record, but packed; field values are decayed
+template <typename... Symbol, typename... Value>
+constexpr auto make_packed_record(field<Symbol, Value> &&... fields)
+{
+  return packed_record<field<Symbol, std::decay_t<Value>>...>{ fields.value()... };
+}
+
+template <typename... Symbol, typename... Value>
+constexpr auto get(struct field_enum const &, packed_record<field<Symbol, Value>...> const &)
+{
+  return field_enum.make(symbol_set<Symbol...>{}, index_sequence_for<Symbol...>{});
+}
+
+template <typename... Symbol, typename... Value, typename Function>
+constexpr auto map(packed_record<field<Symbol, Value>...> &rec, Function &&f)
+{
+  return map(rec, std::forward<Function>(f), symbol_set<Symbol...>{});
+}
+
+template <typename... Symbol, typename... Value, typename Function>
+constexpr auto map(packed_record<field<Symbol, Value>...> const &rec, Function &&f)
+{
+  return map(rec, std::forward<Function>(f), symbol_set<Symbol...>{});
+}
+
+template <typename... Symbol, typename... Value, typename Function>
+constexpr auto map(packed_record<field<Symbol, Value>...> &&rec, Function &&f)
+{
+  return map(std::move(rec), std::forward<Function>(f), symbol_set<Symbol...>{});
+}
+
+// == and != don't depend on field order, so the storage record's serve;
+// these keep < and friends in declaration order
+
+template <typename... Symbols, typename... Values, typename Right>
+constexpr auto operator<(packed_record<field<Symbols, Values>...> const &l, Right const &r)
+    -> enable_if_same_symbols_t<record<field<Symbols, Values>...>, Right>
+{
+  return less_fields(l, r, Symbols{}...);
+}
+
+template <typename... Symbols, typename... Values, typename Right>
+constexpr auto operator>(packed_record<field<Symbols, Values>...> const &l, Right const &r)
+    -> enable_if_same_symbols_t<record<field<Symbols, Values>...>, Right>
+{
+  return less_fields(r, l, Symbols{}...);
+}
+
+template <typename... Symbols, typename... Values, typename Right>
+constexpr auto operator<=(packed_record<field<Symbols, Values>...> const &l, Right const &r)
+    -> enable_if_same_symbols_t<record<field<Symbols, Values>...>, Right>
+{
+  return !less_fields(r, l, Symbols{}...);
+}
+
+template <typename... Symbols, typename... Values, typename Right>
+constexpr auto operator>=(packed_record<field<Symbols, Values>...> const &l, Right const &r)
+    -> enable_if_same_symbols_t<record<field<Symbols, Values>...>, Right>
+{
+  return !less_fields(l, r, Symbols{}...);
+}
+
+} // namespace
+} // namespace rekt
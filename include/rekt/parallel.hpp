@@ -0,0 +1,366 @@
+/// Copyright (c) Benjamin Kietzman (github.com/bkietz)
+///
+/// Distributed under the Boost Software License, Version 1.0. (See accompanying
+/// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace rekt
+{
+namespace
+{
+namespace parallel
+{
+
+///
+/// A fixed set of worker threads, each with its own queue of tasks.
+/// Workers take tasks from the back of their own queue and, when that
+/// is empty, steal from the front of the others'.
+class thread_pool
+{
+public:
+  ///
+  /// Throws std::invalid_argument if threads is 0.
+  explicit thread_pool(std::size_t threads = std::max(1u, std::thread::hardware_concurrency()))
+  {
+    if (threads == 0)
+    {
+      throw std::invalid_argument("thread_pool(): at least one thread is required");
+    }
+    for (std::size_t i = 0; i != threads; ++i)
+    {
+      queues_.emplace_back(new queue);
+    }
+    for (std::size_t i = 0; i != threads; ++i)
+    {
+      workers_.emplace_back([this, i] { work_(i); });
+    }
+  }
+
+  thread_pool(thread_pool const &) = delete;
+  thread_pool &operator=(thread_pool const &) = delete;
+
+  ~thread_pool()
+  {
+    {
+      std::lock_guard<std::mutex> lock(sleep_mutex_);
+      stop_ = true;
+    }
+    wake_.notify_all();
+    for (auto &worker : workers_)
+    {
+      worker.join();
+    }
+  }
+
+  std::size_t size() const
+  {
+    return workers_.size();
+  }
+
+  ///
+  /// Run task(i) for each i in [0, tasks) and return once all have finished.
+  /// The calling thread runs tasks too, so run() may be called from a task.
+  /// If any task throws, the first exception caught is rethrown here.
+  template <typename Task>
+  void run(std::size_t tasks, Task &&task)
+  {
+    if (tasks == 0)
+    {
+      return;
+    }
+
+    batch b{ tasks };
+    std::size_t queued = 0;
+    try
+    {
+      for (; queued != tasks; ++queued)
+      {
+        push_(queued % queues_.size(), [&b, &task, i = queued] {
+          try
+          {
+            task(i);
+          }
+          catch (...)
+          {
+            b.fail(std::current_exception());
+          }
+          b.finish_one();
+        });
+      }
+    }
+    catch (...)
+    {
+      // tasks already queued refer to b, so they must finish before it
+      // goes out of scope
+      b.finish(tasks - queued);
+      while (b.unfinished() && run_one_(0))
+      {
+      }
+      b.wait();
+      throw;
+    }
+
+    while (b.unfinished() && run_one_(0))
+    {
+    }
+    b.wait();
+
+    if (b.error)
+    {
+      std::rethrow_exception(b.error);
+    }
+  }
+
+private:
+  struct queue
+  {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  struct batch
+  {
+    explicit batch(std::size_t tasks)
+        : remaining{ tasks }
+    {
+    }
+
+    std::size_t remaining;
+    std::exception_ptr error;
+    std::mutex mutex;
+    std::condition_variable done;
+
+    // keeps the first exception
+    void fail(std::exception_ptr e)
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (!error)
+      {
+        error = std::move(e);
+      }
+    }
+
+    void finish_one()
+    {
+      finish(1);
+    }
+
+    // finishing under the lock means wait() can't return (and
+    // destroy this batch) until the finishing task is done with it
+    void finish(std::size_t n)
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      remaining -= n;
+      if (remaining == 0)
+      {
+        done.notify_all();
+      }
+    }
+
+    bool unfinished()
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      return remaining != 0;
+    }
+
+    void wait()
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      done.wait(lock, [this] { return remaining == 0; });
+    }
+  };
+
+  void push_(std::size_t home, std::function<void()> task)
+  {
+    {
+      std::lock_guard<std::mutex> lock(queues_[home]->mutex);
+      queues_[home]->tasks.push_back(std::move(task));
+    }
+    ++pending_;
+    {
+      // a worker which just saw no pending tasks is either
+      // not yet waiting or will be woken by this notification
+      std::lock_guard<std::mutex> lock(sleep_mutex_);
+    }
+    wake_.notify_one();
+  }
+
+  bool run_one_(std::size_t home)
+  {
+    std::function<void()> task;
+    for (std::size_t i = 0; i != queues_.size() && !task; ++i)
+    {
+      auto &q = *queues_[(home + i) % queues_.size()];
+      std::lock_guard<std::mutex> lock(q.mutex);
+      if (q.tasks.empty())
+      {
+        continue;
+      }
+      if (i == 0)
+      {
+        task = std::move(q.tasks.back());
+        q.tasks.pop_back();
+      }
+      else
+      {
+        task = std::move(q.tasks.front());
+        q.tasks.pop_front();
+      }
+    }
+
+    if (!task)
+    {
+      return false;
+    }
+    --pending_;
+    task();
+    return true;
+  }
+
+  void work_(std::size_t home)
+  {
+    for (;;)
+    {
+      if (run_one_(home))
+      {
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(sleep_mutex_);
+      wake_.wait(lock, [this] { return stop_ || pending_ != 0; });
+      if (stop_)
+      {
+        return;
+      }
+    }
+  }
+
+  std::vector<std::unique_ptr<queue>> queues_;
+  std::vector<std::thread> workers_;
+  std::atomic<std::size_t> pending_{ 0 };
+  std::mutex sleep_mutex_;
+  std::condition_variable wake_;
+  bool stop_ = false;
+};
+
+///
+/// the pool used when none is specified
+thread_pool &default_pool()
+{
+  static thread_pool pool;
+  return pool;
+}
+
+///
+/// number of rows given to each task when no grain is specified
+constexpr std::size_t default_grain = 1 << 14;
+
+///
+/// Split a random access zip::range (or columns) into chunks of grain rows
+/// and call chunk(first, last) for each on the pool, where first and last
+/// are the range's iterators
+template <typename Range, typename Chunk>
+void for_each_chunk(thread_pool &pool, Range &&zipped, Chunk &&chunk, std::size_t grain = default_grain)
+{
+  grain = std::max(grain, std::size_t(1));
+  auto first = zipped.begin();
+  auto n = static_cast<std::size_t>(zipped.end() - first);
+  pool.run((n + grain - 1) / grain, [&](std::size_t i) {
+    auto b = first + static_cast<std::ptrdiff_t>(i * grain);
+    auto e = first + static_cast<std::ptrdiff_t>(std::min(n, (i + 1) * grain));
+    chunk(b, e);
+  });
+}
+
+///
+/// f(row) for each row of a random access zip::range, in no particular order
+template <typename Range, typename Function>
+void for_each(thread_pool &pool, Range &&zipped, Function &&f, std::size_t grain = default_grain)
+{
+  for_each_chunk(pool, std::forward<Range>(zipped), [&](auto b, auto e) {
+    for (; b != e; ++b)
+    {
+      f(*b);
+    }
+  }, grain);
+}
+
+template <typename Range, typename Function>
+void for_each(Range &&zipped, Function &&f, std::size_t grain = default_grain)
+{
+  for_each(default_pool(), std::forward<Range>(zipped), std::forward<Function>(f), grain);
+}
+
+///
+/// out[i] = f(row i) for each row of a random access zip::range
+template <typename Range, typename RandomAccessIterator, typename Function>
+void transform(thread_pool &pool, Range &&zipped, RandomAccessIterator out, Function &&f, std::size_t grain = default_grain)
+{
+  auto first = zipped.begin();
+  for_each_chunk(pool, std::forward<Range>(zipped), [&](auto b, auto e) {
+    auto o = out + (b - first);
+    for (; b != e; ++b, ++o)
+    {
+      *o = f(*b);
+    }
+  }, grain);
+}
+
+template <typename Range, typename RandomAccessIterator, typename Function>
+void transform(Range &&zipped, RandomAccessIterator out, Function &&f, std::size_t grain = default_grain)
+{
+  transform(default_pool(), std::forward<Range>(zipped), out, std::forward<Function>(f), grain);
+}
+
+///
+/// Combine map(row) for each row of a random access zip::range with op,
+/// starting from init. Each chunk is reduced separately and the partial
+/// results combined in order, so op must be associative (but needn't commute).
+template <typename Range, typename T, typename BinaryOp, typename Map>
+T reduce(thread_pool &pool, Range &&zipped, T init, BinaryOp &&op, Map &&map, std::size_t grain = default_grain)
+{
+  grain = std::max(grain, std::size_t(1));
+  auto first = zipped.begin();
+  auto n = static_cast<std::size_t>(zipped.end() - first);
+  auto chunks = (n + grain - 1) / grain;
+
+  std::vector<std::unique_ptr<T>> partials(chunks);
+  pool.run(chunks, [&](std::size_t i) {
+    auto b = first + static_cast<std::ptrdiff_t>(i * grain);
+    auto e = first + static_cast<std::ptrdiff_t>(std::min(n, (i + 1) * grain));
+    T partial = map(*b);
+    for (++b; b != e; ++b)
+    {
+      partial = op(std::move(partial), map(*b));
+    }
+    partials[i].reset(new T(std::move(partial)));
+  });
+
+  for (auto &partial : partials)
+  {
+    init = op(std::move(init), std::move(*partial));
+  }
+  return init;
+}
+
+template <typename Range, typename T, typename BinaryOp, typename Map>
+T reduce(Range &&zipped, T init, BinaryOp &&op, Map &&map, std::size_t grain = default_grain)
+{
+  return reduce(default_pool(), std::forward<Range>(zipped), std::move(init), std::forward<BinaryOp>(op), std::forward<Map>(map), grain);
+}
+
+} // namespace parallel
+} // namespace
+} // namespace rekt
@@ -0,0 +1,276 @@
+/// Copyright (c) Benjamin Kietzman (github.com/bkietz)
+///
+/// Distributed under the Boost Software License, Version 1.0. (See accompanying
+/// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <rekt/iterator.hpp>
+#include <tuple>
+
+namespace rekt
+{
+namespace
+{
+
+///
+/// Query stages. Each is called with a row and the rest of the pipeline
+/// (next), and passes rows on by calling next(row). Both return false
+/// once no more rows are wanted, which ends the query early.
+
+template <typename Predicate>
+struct where_t
+{
+  Predicate predicate;
+
+  template <typename Row, typename Next>
+  bool operator()(Row &row, Next &&next)
+  {
+    return predicate(row) ? next(row) : true;
+  }
+};
+
+template <typename Predicate>
+struct take_while_t
+{
+  Predicate predicate;
+
+  template <typename Row, typename Next>
+  bool operator()(Row &row, Next &&next)
+  {
+    return predicate(row) && next(row);
+  }
+};
+
+template <typename... Symbols>
+struct select_t
+{
+  template <typename Row, typename Next>
+  bool operator()(Row &row, Next &&next)
+  {
+    // like take(), but without copying row's fields
+    auto selected = forward_as_record(make_field(Symbols{}, get(Symbols{}, row))...);
+    return next(selected);
+  }
+};
+
+struct take_n_t
+{
+  std::size_t n, taken;
+
+  template <typename Row, typename Next>
+  bool operator()(Row &row, Next &&next)
+  {
+    if (taken == n)
+    {
+      return false;
+    }
+    ++taken;
+    return next(row) && taken != n;
+  }
+};
+
+struct drop_n_t
+{
+  std::size_t n, dropped;
+
+  template <typename Row, typename Next>
+  bool operator()(Row &row, Next &&next)
+  {
+    if (dropped != n)
+    {
+      ++dropped;
+      return true;
+    }
+    return next(row);
+  }
+};
+
+///
+/// rows for which predicate(row) is true
+template <typename Predicate>
+where_t<std::decay_t<Predicate>> where(Predicate &&predicate)
+{
+  return { std::forward<Predicate>(predicate) };
+}
+
+///
+/// rows up to (not including) the first for which predicate(row) is false
+template <typename Predicate>
+take_while_t<std::decay_t<Predicate>> take_while(Predicate &&predicate)
+{
+  return { std::forward<Predicate>(predicate) };
+}
+
+///
+/// only the fields for some symbols of each row, as a record of references
+template <typename... Symbols>
+constexpr select_t<Symbols...> select(Symbols const &...)
+{
+  return {};
+}
+
+///
+/// the first n rows
+constexpr take_n_t take_n(std::size_t n)
+{
+  return { n, 0 };
+}
+
+///
+/// all but the first n rows
+constexpr drop_n_t drop_n(std::size_t n)
+{
+  return { n, 0 };
+}
+
+template <typename Stage>
+struct is_query_stage : std::false_type
+{
+};
+
+template <typename Predicate>
+struct is_query_stage<where_t<Predicate>> : std::true_type
+{
+};
+
+template <typename Predicate>
+struct is_query_stage<take_while_t<Predicate>> : std::true_type
+{
+};
+
+template <typename... Symbols>
+struct is_query_stage<select_t<Symbols...>> : std::true_type
+{
+};
+
+template <>
+struct is_query_stage<take_n_t> : std::true_type
+{
+};
+
+template <>
+struct is_query_stage<drop_n_t> : std::true_type
+{
+};
+
+///
+/// A range with a sequence of stages to apply to its rows. Nothing is
+/// evaluated until a query is run by one of its terminal operations.
+/// Rows are then pushed through every stage in turn by a single loop
+/// over the range, rather than pulled through a stack of iterator
+/// adaptors, and no stage stores intermediate rows.
+///
+///     (zip(name = names, score = scores)
+///         | where([&](auto &&r) { return score(r) > 0.5; })
+///         | select(name)
+///         | take_n(10))
+///         .for_each([&](auto &&r) { std::cout << name(r) << std::endl; });
+///
+/// Each run starts from fresh copies of the stages, so a query may be run
+/// more than once. Ranges passed as lvalues must outlive the query;
+/// temporaries are moved into it.
+template <typename Range, typename... Stages>
+class query
+{
+public:
+  template <typename R, typename... S>
+  query(R &&range, S &&... stages)
+      : range_(std::forward<R>(range)), stages_{ std::forward<S>(stages)... }
+  {
+  }
+
+  ///
+  /// f(row) for each row which reaches the end of the query
+  template <typename Function>
+  void for_each(Function &&f)
+  {
+    run_([&](auto &row) { f(row); });
+  }
+
+  ///
+  /// number of rows which reach the end of the query
+  std::size_t count()
+  {
+    std::size_t n = 0;
+    run_([&](auto &) { ++n; });
+    return n;
+  }
+
+  ///
+  /// push_back each row which reaches the end of the query into a
+  /// container (a columns or a std::vector of records, for example)
+  template <typename Container>
+  Container &into(Container &c)
+  {
+    run_([&](auto &row) { c.push_back(row); });
+    return c;
+  }
+
+  template <typename Stage, typename = std::enable_if_t<is_query_stage<std::decay_t<Stage>>::value>>
+  friend query<Range, Stages..., std::decay_t<Stage>> operator|(query q, Stage &&stage)
+  {
+    return q.then_(std::forward<Stage>(stage), std::index_sequence_for<Stages...>{});
+  }
+
+private:
+  template <typename Stage, std::size_t... I>
+  query<Range, Stages..., std::decay_t<Stage>> then_(Stage &&stage, std::index_sequence<I...>)
+  {
+    return { std::forward<zip::owned_t<Range &&>>(range_), std::move(std::get<I>(stages_))..., std::forward<Stage>(stage) };
+  }
+
+  template <typename Sink>
+  void run_(Sink &&sink)
+  {
+    auto stages = stages_;
+    for (auto it = range_.begin(), end = range_.end(); it != end; ++it)
+    {
+      auto &&row = *it;
+      if (!push_(stages, row, sink, std::integral_constant<std::size_t, 0>{}))
+      {
+        break;
+      }
+    }
+  }
+
+  template <typename Row, typename Sink, std::size_t I>
+  static bool push_(std::tuple<Stages...> &stages, Row &row, Sink &sink, std::integral_constant<std::size_t, I>)
+  {
+    return std::get<I>(stages)(row, [&](auto &next_row) {
+      return push_(stages, next_row, sink, std::integral_constant<std::size_t, I + 1>{});
+    });
+  }
+
+  template <typename Row, typename Sink>
+  static bool push_(std::tuple<Stages...> &, Row &row, Sink &sink, std::integral_constant<std::size_t, sizeof...(Stages)>)
+  {
+    sink(row);
+    return true;
+  }
+
+  zip::owned_t<Range &&> range_;
+  std::tuple<Stages...> stages_;
+};
+
+template <typename Range>
+struct is_query : std::false_type
+{
+};
+
+template <typename Range, typename... Stages>
+struct is_query<query<Range, Stages...>> : std::true_type
+{
+};
+
+///
+/// Start a query with a range (a zip::range or columns, for example)
+template <typename Range, typename Stage,
+          typename = std::enable_if_t<is_query_stage<std::decay_t<Stage>>::value && !is_query<std::decay_t<Range>>::value>>
+query<Range, std::decay_t<Stage>> operator|(Range &&range, Stage &&stage)
+{
+  return { std::forward<Range>(range), std::forward<Stage>(stage) };
+}
+
+} // namespace
+} // namespace rekt
@@ -5,6 +5,7 @@
 
 #pragma once
 
+#include <initializer_list>
 #include <rekt/detail/array.hpp>
 #include <rekt/detail/storage.hpp>
 #include <rekt/record_traits.hpp>
@@ -75,28 +76,72 @@ constexpr auto make_field(Symbol const &, Value &&v)
   return field<Symbol, decltype(std::forward<Value &&>(v))>(std::forward<Value &&>(v));
 }
 
+template <typename... Fields>
+class record;
+
+///
+/// Whether a record can be assigned from another by copying its bytes:
+/// they are the same record of trivially copyable values, and every field
+/// is assigned
+template <typename Target, typename Source, typename SymbolSet>
+struct bitwise_assignable : std::false_type
+{
+};
+
+template <typename... Symbol, typename... Value, typename... Symbols>
+struct bitwise_assignable<record<field<Symbol, Value>...>, record<field<Symbol, Value>...>, symbol_set<Symbols...>>
+    : integer_constant<bool, sizeof...(Symbols) == sizeof...(Symbol) && all_true({ std::is_trivially_copyable<Value>::value... })>
+{
+};
+
+template <typename Target, typename Source, typename... Symbols>
+void assign_fields_(Target &t, Source &&s, symbol_set<Symbols...> const &, std::false_type /* bitwise */)
+{
+  symbol_set<Symbols...>{ (get(Symbols{}, t) = get(Symbols{}, std::forward<Source>(s)), Symbols{})... };
+}
+
+template <typename Target, typename Source, typename... Symbols>
+void assign_fields_(Target &t, Source &&s, symbol_set<Symbols...> const &, std::true_type /* bitwise */)
+{
+  // the implicit trivial assignment: a bulk copy like memcpy, which unlike
+  // memcpy leaves alone any derived class members in the tail padding
+  t = std::forward<Source>(s);
+}
+
 ///
 /// assign field values in one record to those in another for each
-/// field associated with the symbols in a symbol_set
+/// field associated with the symbols in a symbol_set. Records of the same
+/// trivially copyable type are copied in bulk, rather than field by
+/// field, when every field is assigned.
 template <typename Target, typename Source, typename... Symbols>
-decltype(auto) assign_fields(Target &&t, Source &&s, symbol_set<Symbols...> const &)
+decltype(auto) assign_fields(Target &&t, Source &&s, symbol_set<Symbols...> const &symbols)
 {
   static_assert(has_all<symbol_set<Symbols...>, Target &&>, "fields were not defined on target record for all symbols in assign_fields() call");
   static_assert(has_all<symbol_set<Symbols...>, Source &&>, "fields were not defined on source record for all symbols in assign_fields() call");
-  symbol_set<Symbols...>{ (get(Symbols{}, std::forward<Target>(t)) = get(Symbols{}, std::forward<Source>(s)), Symbols{})... };
+  assign_fields_(t, std::forward<Source>(s), symbols,
+                 bitwise_assignable<std::remove_cv_t<std::remove_reference_t<Target>>, std::decay_t<Source>, symbol_set<Symbols...>>{});
   return std::forward<Target>(t);
 }
 
 ///
-/// simple implementation of a record with several stored fields
-template <typename... Fields>
-class record;
-
+/// simple implementation of a record with several stored fields.
+/// A record whose values are all trivially copyable is trivially copyable
+/// too (so it can be memcpy'd, or placed in shared memory), and is always
+/// assigned from the same record type trivially. It is not standard
+/// layout: each field is a separate base class.
 template <typename... Symbol, typename... Value>
 class record<field<Symbol, Value>...>
     : private symbol_set<Symbol...>,
       public field<Symbol, Value>...
 {
+  // a non-const lvalue of the same record binds better to the template
+  // operator= below than to the implicit copy assignment (which takes
+  // const &), and would be assigned field by field. When every value is
+  // trivially copyable the template steps aside for the trivial operator.
+  template <typename OtherRecord>
+  using enable_if_not_trivial_copy = std::enable_if_t<!(std::is_same<std::decay_t<OtherRecord>, record>::value &&
+                                                        all_true({ std::is_trivially_copyable<Value>::value... }))>;
+
 public:
   constexpr record() = default;
 
@@ -110,13 +155,38 @@ public:
   {
   }
 
+  ///
+  /// uses-allocator construction: each value which uses an allocator is
+  /// built with a, either from no arguments or from one argument per field
+  ///
+  ///     person p{ std::allocator_arg, arena, "a name", 30 };
+  template <typename Alloc, typename... Args,
+            typename = std::enable_if_t<sizeof...(Args) == 0 || sizeof...(Args) == sizeof...(Symbol)>>
+  record(std::allocator_arg_t, Alloc const &a, Args &&... args)
+      : record(std::allocator_arg, a, integer_c<bool, sizeof...(Args) == 0>, std::forward<Args>(args)...)
+  {
+  }
+
   ///
   /// defined to enable std::tie style assignment
-  template <typename OtherRecord>
+  template <typename OtherRecord, typename = enable_if_not_trivial_copy<OtherRecord>>
   record &operator=(OtherRecord &&other)
   {
     return assign_fields(*this, std::forward<OtherRecord>(other), symbol_set<Symbol...>{});
   }
+
+private:
+  template <typename Alloc>
+  record(std::allocator_arg_t, Alloc const &a, std::true_type /* default */)
+      : field<Symbol, Value>{ std::allocator_arg, a }...
+  {
+  }
+
+  template <typename Alloc, typename... Args>
+  record(std::allocator_arg_t, Alloc const &a, std::false_type /* default */, Args &&... args)
+      : field<Symbol, Value>{ std::allocator_arg, a, std::forward<Args>(args) }...
+  {
+  }
 };
 
 template <>
@@ -139,6 +209,18 @@ constexpr auto make_record(field<Symbol, Value> &&... fields)
   return record<field<Symbol, std::decay_t<Value>>...>{ fields.value()... };
 }
 
+///
+/// make_record with uses-allocator construction of the decayed values:
+/// those which use an allocator (strings and vectors with an arena's
+/// allocator, say) are copied or moved into storage from a
+///
+///     make_record(std::allocator_arg, arena, name = n, friends = f)
+template <typename Alloc, typename... Symbol, typename... Value>
+auto make_record(std::allocator_arg_t, Alloc const &a, field<Symbol, Value> &&... fields)
+{
+  return record<field<Symbol, std::decay_t<Value>>...>{ std::allocator_arg, a, static_cast<Value &&>(fields.value())... };
+}
+
 ///
 /// forward_as_record leaves references undecayed
 template <typename... Symbol, typename... Value>
@@ -147,6 +229,97 @@ constexpr auto forward_as_record(field<Symbol, Value> &&... fields)
   return record<field<Symbol, Value>...>{ std::move(fields)... };
 }
 
+///
+/// Whether two rows have equal fields for some symbols
+template <typename Left, typename Right, typename... Symbols>
+constexpr bool equal_fields(Left const &l, Right const &r, Symbols const &...)
+{
+  bool equal = true;
+  (void)std::initializer_list<int>{ (equal = equal && get(Symbols{}, l) == get(Symbols{}, r), 0)... };
+  return equal;
+}
+
+template <typename Left, typename Right>
+constexpr bool less_fields(Left const &, Right const &)
+{
+  return false;
+}
+
+///
+/// Whether one row's fields for some symbols are lexicographically less than another's
+template <typename Left, typename Right, typename Symbol, typename... Symbols>
+constexpr bool less_fields(Left const &l, Right const &r, Symbol const &, Symbols const &... rest)
+{
+  return get(Symbol{}, l) < get(Symbol{}, r) ||
+         (!(get(Symbol{}, r) < get(Symbol{}, l)) && less_fields(l, r, rest...));
+}
+
+template <typename Left, typename Right>
+struct same_symbols : std::false_type
+{
+};
+
+template <typename... LeftSymbols, typename... LeftValues, typename... RightSymbols, typename... RightValues>
+struct same_symbols<record<field<LeftSymbols, LeftValues>...>, record<field<RightSymbols, RightValues>...>>
+    : integer_constant<bool, sizeof...(LeftSymbols) == sizeof...(RightSymbols) &&
+                                 has_all<symbol_set<LeftSymbols...>, record<field<RightSymbols, RightValues>...> const &>>
+{
+};
+
+// the record a type derives from (zip::reference, for example); only for decltype
+template <typename... Symbols, typename... Values>
+record<field<Symbols, Values>...> record_base(record<field<Symbols, Values>...> const &);
+
+template <typename Left, typename Right>
+using enable_if_same_symbols_t = std::enable_if_t<same_symbols<Left, decltype(record_base(std::declval<Right const &>()))>::value, bool>;
+
+///
+/// Records with the same symbols compare field by field, whatever order
+/// their fields were declared in and whether they hold values or references
+/// (so the rows of a zip::range compare with records too). < is
+/// lexicographic, in the order of the left record's fields.
+template <typename... Symbols, typename... Values, typename Right>
+constexpr auto operator==(record<field<Symbols, Values>...> const &l, Right const &r)
+    -> enable_if_same_symbols_t<record<field<Symbols, Values>...>, Right>
+{
+  return equal_fields(l, r, Symbols{}...);
+}
+
+template <typename... Symbols, typename... Values, typename Right>
+constexpr auto operator!=(record<field<Symbols, Values>...> const &l, Right const &r)
+    -> enable_if_same_symbols_t<record<field<Symbols, Values>...>, Right>
+{
+  return !equal_fields(l, r, Symbols{}...);
+}
+
+template <typename... Symbols, typename... Values, typename Right>
+constexpr auto operator<(record<field<Symbols, Values>...> const &l, Right const &r)
+    -> enable_if_same_symbols_t<record<field<Symbols, Values>...>, Right>
+{
+  return less_fields(l, r, Symbols{}...);
+}
+
+template <typename... Symbols, typename... Values, typename Right>
+constexpr auto operator>(record<field<Symbols, Values>...> const &l, Right const &r)
+    -> enable_if_same_symbols_t<record<field<Symbols, Values>...>, Right>
+{
+  return less_fields(r, l, Symbols{}...);
+}
+
+template <typename... Symbols, typename... Values, typename Right>
+constexpr auto operator<=(record<field<Symbols, Values>...> const &l, Right const &r)
+    -> enable_if_same_symbols_t<record<field<Symbols, Values>...>, Right>
+{
+  return !less_fields(r, l, Symbols{}...);
+}
+
+template <typename... Symbols, typename... Values, typename Right>
+constexpr auto operator>=(record<field<Symbols, Values>...> const &l, Right const &r)
+    -> enable_if_same_symbols_t<record<field<Symbols, Values>...>, Right>
+{
+  return !less_fields(l, r, Symbols{}...);
+}
+
 ///
 /// CRTP helper for augmenting tag types used as symbols with some
 /// nifty, Haskell-style operator overloads
@@ -343,7 +516,7 @@ class merged_records
 {
 public:
   constexpr merged_records(RecordRefs... refs)
-      : refs_{ static_cast<RecordRefs>(refs)... }
+      : refs_{ std::forward<RecordRefs>(refs)... }
   {
   }
 
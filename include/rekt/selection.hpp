@@ -0,0 +1,400 @@
+/// Copyright (c) Benjamin Kietzman (github.com/bkietz)
+///
+/// Distributed under the Boost Software License, Version 1.0. (See accompanying
+/// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <algorithm>
+#include <rekt/bitmap.hpp>
+#include <rekt/columns.hpp>
+#include <rekt/expression.hpp>
+#include <stdexcept>
+
+namespace rekt
+{
+namespace
+{
+
+///
+/// A subset of the rows of a range, by row number. Sparse selections are
+/// stored as a sorted list of row numbers, dense ones as a bitmap, so that
+/// neither takes much more than the other would:
+///
+///     selection s(where(people, age > 18)); // usually from a bitmap
+///     for (auto row : s) // the selected row numbers, ascending
+///
+/// Selections do not refer to any range; see filter() and materialize().
+class selection
+{
+public:
+  class iterator;
+
+  /// selections with fewer than one row in this many
+  /// selected store row numbers rather than a bitmap
+  static constexpr std::size_t sparse_ratio = 32;
+
+  selection() = default;
+
+  explicit selection(bitmap bits)
+      : rows_{ bits.size() }, selected_{ bits.count() }
+  {
+    if (selected_ * sparse_ratio >= rows_)
+    {
+      bits_ = std::move(bits);
+      return;
+    }
+    indices_.reserve(selected_);
+    for (std::size_t w = 0; w != bitmap::words_for(rows_); ++w)
+    {
+      for (auto word = bits.words()[w]; word != 0; word &= word - 1)
+      {
+        indices_.push_back(w * bitmap::word_bits + bitmap::lowest_set(word));
+      }
+    }
+  }
+
+  ///
+  /// select the given (ascending) row numbers of a range with rows rows
+  selection(std::vector<std::size_t> indices, std::size_t rows)
+      : rows_{ rows }, selected_{ indices.size() }, indices_(std::move(indices))
+  {
+  }
+
+  ///
+  /// number of selected rows
+  std::size_t size() const
+  {
+    return selected_;
+  }
+
+  bool empty() const
+  {
+    return selected_ == 0;
+  }
+
+  ///
+  /// number of rows in the range the selection applies to
+  std::size_t rows() const
+  {
+    return rows_;
+  }
+
+  ///
+  /// whether the selection is stored as a bitmap
+  bool dense() const
+  {
+    return bits_.size() != 0 || rows_ == 0;
+  }
+
+  bool test(std::size_t row) const
+  {
+    return dense() ? bits_.test(row) : std::binary_search(indices_.begin(), indices_.end(), row);
+  }
+
+  iterator begin() const;
+  iterator end() const;
+
+private:
+  std::size_t rows_ = 0, selected_ = 0;
+  bitmap bits_;
+  std::vector<std::size_t> indices_;
+};
+
+constexpr std::size_t selection::sparse_ratio;
+
+///
+/// Iterates the row numbers of a selection in ascending order
+class selection::iterator
+{
+public:
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = std::size_t;
+  using reference = std::size_t;
+  using pointer = std::size_t const *;
+  using difference_type = std::ptrdiff_t;
+
+  iterator() = default;
+
+  iterator(selection const &s, std::size_t rank)
+      : s_{ &s }, rank_{ rank }
+  {
+    if (!s.dense() || rank == s.size())
+    {
+      return;
+    }
+    word_ = static_cast<std::size_t>(-1);
+    next_word_();
+  }
+
+  std::size_t operator*() const
+  {
+    return s_->dense() ? row_ : s_->indices_[rank_];
+  }
+
+  iterator &operator++()
+  {
+    if (++rank_ != s_->size() && s_->dense())
+    {
+      if (bits_ == 0)
+      {
+        next_word_();
+      }
+      else
+      {
+        take_bit_();
+      }
+    }
+    return *this;
+  }
+
+  iterator operator++(int)
+  {
+    auto copy = *this;
+    ++*this;
+    return copy;
+  }
+
+  ///
+  /// number of selected rows before this one
+  std::size_t rank() const
+  {
+    return rank_;
+  }
+
+  friend bool operator==(iterator const &l, iterator const &r)
+  {
+    return l.rank_ == r.rank_;
+  }
+
+  friend bool operator!=(iterator const &l, iterator const &r)
+  {
+    return l.rank_ != r.rank_;
+  }
+
+private:
+  void next_word_()
+  {
+    do
+    {
+      bits_ = s_->bits_.words()[++word_];
+    } while (bits_ == 0);
+    take_bit_();
+  }
+
+  void take_bit_()
+  {
+    row_ = word_ * bitmap::word_bits + bitmap::lowest_set(bits_);
+    bits_ &= bits_ - 1;
+  }
+
+  selection const *s_ = nullptr;
+  std::size_t rank_ = 0;
+  // for bitmaps: the current row, its word, and the bits of that word after it
+  std::size_t row_ = 0, word_ = 0;
+  bitmap::word_type bits_ = 0;
+};
+
+selection::iterator selection::begin() const
+{
+  return iterator{ *this, 0 };
+}
+
+selection::iterator selection::end() const
+{
+  return iterator{ *this, selected_ };
+}
+
+///
+/// Visits the elements of a random access iterator which are selected.
+/// get() on a selection_iterator over a zip::iterator yields a
+/// selection_iterator over that column, so code which walks columns
+/// separately (group_by, for example) respects the selection too.
+template <typename Iterator>
+class selection_iterator
+{
+public:
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = typename std::iterator_traits<Iterator>::value_type;
+  using reference = typename std::iterator_traits<Iterator>::reference;
+  using pointer = typename std::iterator_traits<Iterator>::pointer;
+  using difference_type = std::ptrdiff_t;
+
+  selection_iterator() = default;
+
+  selection_iterator(Iterator first, selection::iterator cursor)
+      : first_{ first }, cursor_{ cursor }
+  {
+  }
+
+  reference operator*() const
+  {
+    return first_[static_cast<difference_type>(*cursor_)];
+  }
+
+  selection_iterator &operator++()
+  {
+    ++cursor_;
+    return *this;
+  }
+
+  selection_iterator operator++(int)
+  {
+    auto copy = *this;
+    ++cursor_;
+    return copy;
+  }
+
+  ///
+  /// the first element of the underlying sequence
+  Iterator const &base() const
+  {
+    return first_;
+  }
+
+  selection::iterator const &cursor() const
+  {
+    return cursor_;
+  }
+
+  template <typename Symbol>
+  friend auto get(Symbol const &s, selection_iterator const &it)
+      -> selection_iterator<std::decay_t<decltype(get(s, it.base()))>>
+  {
+    return { get(s, it.base()), it.cursor() };
+  }
+
+  friend bool operator==(selection_iterator const &l, selection_iterator const &r)
+  {
+    return l.cursor_ == r.cursor_;
+  }
+
+  friend bool operator!=(selection_iterator const &l, selection_iterator const &r)
+  {
+    return l.cursor_ != r.cursor_;
+  }
+
+private:
+  Iterator first_;
+  selection::iterator cursor_;
+};
+
+///
+/// The selected rows of a range; see filter()
+template <typename Range, typename Selection>
+class filtered_range
+{
+public:
+  using iterator = selection_iterator<decltype(std::declval<std::remove_reference_t<Range> &>().begin())>;
+
+  template <typename R, typename S>
+  filtered_range(R &&range, S &&s)
+      : range_(std::forward<R>(range)), selection_(std::forward<S>(s))
+  {
+    if (static_cast<std::size_t>(range_.end() - range_.begin()) != selection_.rows())
+    {
+      throw std::length_error("filter(): the selection is not for a range of this length");
+    }
+  }
+
+  iterator begin()
+  {
+    return { range_.begin(), selection_.begin() };
+  }
+
+  iterator end()
+  {
+    return { range_.begin(), selection_.end() };
+  }
+
+  std::size_t size() const
+  {
+    return selection_.size();
+  }
+
+  bool empty() const
+  {
+    return selection_.empty();
+  }
+
+private:
+  zip::owned_t<Range &&> range_;
+  zip::owned_t<Selection &&> selection_;
+};
+
+///
+/// View only the selected rows of a random access zip::range (or columns).
+/// Rows which aren't selected are never touched, by iteration or by
+/// anything which walks a range forward (group_by, queries, the left
+/// side of hash_join):
+///
+///     group_by(filter(people, where(people, age > 18)), city).aggregate(n = count());
+///
+/// Filtered ranges are forward ranges, so they can't be the right (build)
+/// side of hash_join, or be sorted; materialize() the selection for those.
+///
+/// Throws std::length_error if the selection is for a different number of rows.
+/// Ranges and selections passed as lvalues must outlive the filtered range;
+/// temporaries are moved into it.
+template <typename Range, typename Selection, typename = std::enable_if_t<std::is_same<std::decay_t<Selection>, selection>::value>>
+filtered_range<Range, Selection> filter(Range &&zipped, Selection &&s)
+{
+  return { std::forward<Range>(zipped), std::forward<Selection>(s) };
+}
+
+///
+/// shorthand for filter(zipped, selection(where(zipped, e)))
+template <typename Range, typename Expression>
+filtered_range<Range, selection> filter(Range &&zipped, expression<Expression> const &e)
+{
+  selection s(where(zipped, e));
+  return { std::forward<Range>(zipped), std::move(s) };
+}
+
+template <typename ColumnIterator, typename Column>
+void materialize_column(ColumnIterator column, selection const &s, Column &out)
+{
+  out.reserve(s.size());
+  for (auto row : s)
+  {
+    out.push_back(column[static_cast<std::ptrdiff_t>(row)]);
+  }
+}
+
+template <typename Iterator, typename... Symbols>
+auto materialize_columns(Iterator first, selection const &s, symbol_set<Symbols...>)
+{
+  using values = record<field<Symbols, typename std::iterator_traits<std::decay_t<decltype(get(Symbols{}, first))>>::value_type>...>;
+  columns<values> result;
+  symbol_set<Symbols...>{ (materialize_column(get(Symbols{}, first), s, get(Symbols{}, result)), Symbols{})... };
+  return result;
+}
+
+template <typename Iterator, typename... Symbols, typename... Values>
+auto materialize_columns(Iterator first, selection const &s, type_constant<record<field<Symbols, Values>...>>)
+{
+  return materialize_columns(first, s, symbol_set<Symbols...>{});
+}
+
+///
+/// Copy the selected rows of a random access zip::range (or columns) into
+/// columns, one column at a time. If any symbols are given, only those
+/// columns are copied and the others are never read:
+///
+///     auto adults = materialize(people, where(people, age > 18), name, city);
+///
+/// Throws std::length_error if the selection is for a different number of rows.
+template <typename Range, typename... Symbols>
+auto materialize(Range &&zipped, selection const &s, Symbols const &...)
+{
+  auto first = zipped.begin();
+  if (static_cast<std::size_t>(zipped.end() - first) != s.rows())
+  {
+    throw std::length_error("materialize(): the selection is not for a range of this length");
+  }
+  using value_type = typename std::iterator_traits<decltype(first)>::value_type;
+  return materialize_columns(first, s, std::conditional_t<sizeof...(Symbols) == 0, type_constant<value_type>, symbol_set<Symbols...>>{});
+}
+
+} // namespace
+} // namespace rekt
@@ -0,0 +1,198 @@
+/// Copyright (c) Benjamin Kietzman (github.com/bkietz)
+///
+/// Distributed under the Boost Software License, Version 1.0. (See accompanying
+/// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <rekt/iterator.hpp>
+
+/// REKT_SIMD_BYTES is the width of the packs used by simd::transform.
+/// It defaults to the widest registers the compiler was told to target.
+#ifndef REKT_SIMD_BYTES
+#if defined(__AVX__)
+#define REKT_SIMD_BYTES 32
+#else
+#define REKT_SIMD_BYTES 16
+#endif
+#endif
+
+/// Packs are GCC/Clang vector extension types. Elsewhere they fall back
+/// to scalars, one lane wide.
+#ifndef REKT_SIMD_VECTOR_EXTENSIONS
+#if defined(__GNUC__) || defined(__clang__)
+#define REKT_SIMD_VECTOR_EXTENSIONS 1
+#else
+#define REKT_SIMD_VECTOR_EXTENSIONS 0
+#endif
+#endif
+
+namespace rekt
+{
+namespace
+{
+namespace simd
+{
+
+#if REKT_SIMD_VECTOR_EXTENSIONS
+
+template <typename Element>
+constexpr std::size_t lanes = REKT_SIMD_BYTES / sizeof(Element) == 0 ? 1 : REKT_SIMD_BYTES / sizeof(Element);
+
+template <typename Element>
+struct pack_type
+{
+  typedef Element type __attribute__((vector_size(sizeof(Element) * lanes<Element>)));
+};
+
+#else
+
+template <typename Element>
+constexpr std::size_t lanes = 1;
+
+template <typename Element>
+struct pack_type
+{
+  using type = Element;
+};
+
+#endif
+
+///
+/// lanes<Element> consecutive Elements, which support the arithmetic,
+/// bitwise, and comparison operators element-wise (comparisons yield
+/// packs of integers, -1 for true and 0 for false)
+template <typename Element>
+using pack = typename pack_type<Element>::type;
+
+template <typename Element, typename Source>
+pack<Element> load(Source const *source, std::true_type /* same type */)
+{
+  pack<Element> p;
+  std::memcpy(&p, source, sizeof(p));
+  return p;
+}
+
+template <typename Element, typename Source>
+pack<Element> load(Source const *source, std::false_type /* same type */)
+{
+  Element converted[lanes<Element>];
+  for (std::size_t l = 0; l != lanes<Element>; ++l)
+  {
+    converted[l] = static_cast<Element>(source[l]);
+  }
+  return load<Element>(converted, std::true_type{});
+}
+
+///
+/// read lanes<Element> consecutive Sources into a pack of Elements
+template <typename Element, typename Source>
+pack<Element> load(Source const *source)
+{
+  return load<Element>(source, std::is_same<Element, Source>{});
+}
+
+///
+/// read the n (fewer than lanes<Element>, but at least one) Sources left
+/// at the end of a column into a pack of Elements. The remaining lanes
+/// repeat the last Source, so they can't fault where a real row wouldn't
+/// (by dividing by zero, say).
+template <typename Element, typename Source>
+pack<Element> load_partial(Source const *source, std::size_t n)
+{
+  Element converted[lanes<Element>];
+  for (std::size_t l = 0; l != lanes<Element>; ++l)
+  {
+    converted[l] = static_cast<Element>(source[std::min(l, n - 1)]);
+  }
+  return load<Element>(converted, std::true_type{});
+}
+
+// a scalar result is broadcast to every lane
+template <typename Element, typename Destination, typename Result>
+void store(Destination *destination, Result const &r, std::true_type /* scalar */)
+{
+  std::fill(destination, destination + lanes<Element>, static_cast<Destination>(r));
+}
+
+template <typename Element, typename Destination, typename Result>
+void store(Destination *destination, Result const &r, std::false_type /* scalar */)
+{
+  for (std::size_t l = 0; l != lanes<Element>; ++l)
+  {
+    destination[l] = static_cast<Destination>(r[l]);
+  }
+}
+
+///
+/// write the lanes of a pack (with lanes<Element> lanes) to consecutive Destinations
+template <typename Element, typename Destination, typename Result>
+void store(Destination *destination, Result const &r)
+{
+  store<Element>(destination, r, std::is_arithmetic<Result>{});
+}
+
+template <typename Iterator, typename... Symbols, typename... Pointers, typename Destination, typename Function>
+void transform(Iterator first, std::size_t n, Destination *destination, Function &f, type_constant<record<field<Symbols, Pointers>...>>)
+{
+  using common = std::common_type_t<std::remove_cv_t<std::remove_pointer_t<Pointers>>...>;
+  static_assert(std::is_arithmetic<common>::value && !std::is_same<common, bool>::value,
+                "simd::transform requires columns of arithmetic (non-bool) type");
+  // packs aren't promoted, so narrow integers are widened as scalars would be
+  using element = decltype(+std::declval<common>());
+
+  std::size_t i = 0;
+  for (; i + lanes<element> <= n; i += lanes<element>)
+  {
+    store<element>(destination + i, f(load<element>(get(Symbols{}, first) + i)...));
+  }
+  // the tail goes through f as a whole pack too, so that it is computed
+  // with the same arithmetic
+  if (i != n)
+  {
+    Destination tail[lanes<element>];
+    store<element>(tail, f(load_partial<element>(get(Symbols{}, first) + i, n - i)...));
+    std::copy(tail, tail + (n - i), destination + i);
+  }
+}
+
+///
+/// Compute destination[i] = f(a[i], b[i], ...) for each row of a zip::range
+/// of contiguous arithmetic columns, a batch of lanes at a time:
+///
+///     simd::transform(zip(price = prices, qty = qtys), total = totals,
+///                     [](auto price, auto qty) { return price * qty; });
+///
+/// f receives one argument per zipped symbol, in the order they were zipped.
+/// Each column is converted to the common type of all the columns, promoted
+/// as a scalar would be (so int8_t and int16_t columns become packs of
+/// int), and f is called with packs of that type, even for the last few
+/// rows (fewer than a pack). An int8_t column of 100s squared gives 10000,
+/// just as the scalar loop would.
+///
+/// Throws std::length_error if destination is shorter than the range.
+template <typename Range, typename Symbol, typename Container, typename Function>
+void transform(Range &&zipped, field<Symbol, Container> destination, Function &&f)
+{
+  auto first = zipped.begin();
+  using iterator_record = typename decltype(first)::iterator_record;
+  static_assert(std::is_same<typename zip::iterator_category<iterator_record>::type, zip::contiguous_iterator_tag>::value,
+                "simd::transform requires contiguous columns");
+
+  auto n = static_cast<std::size_t>(zipped.end() - first);
+  auto &&container = destination.value();
+  auto out = zip::begin{}(Symbol{}, container);
+  static_assert(std::is_pointer<decltype(out)>::value, "simd::transform requires a contiguous destination");
+  if (zip::size_of(container) < n)
+  {
+    throw std::length_error("simd::transform(): destination is shorter than the range");
+  }
+
+  transform(first, n, out, f, type_c<iterator_record>);
+}
+
+} // namespace simd
+} // namespace
+} // namespace rekt
@@ -0,0 +1,292 @@
+/// Copyright (c) Benjamin Kietzman (github.com/bkietz)
+///
+/// Distributed under the Boost Software License, Version 1.0. (See accompanying
+/// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <initializer_list>
+#include <numeric>
+#include <rekt/columns.hpp>
+#include <rekt/detail/radix_sort.hpp>
+#include <rekt/iterator.hpp>
+
+namespace rekt
+{
+namespace
+{
+
+///
+/// Move element indices[i] of column to its position i, through a buffer
+template <typename ColumnIterator, typename Element>
+void gather_column(ColumnIterator column, std::vector<std::size_t> const &indices, type_constant<Element>)
+{
+  std::vector<Element> gathered;
+  gathered.reserve(indices.size());
+  for (auto i : indices)
+  {
+    gathered.push_back(std::move(column[static_cast<std::ptrdiff_t>(i)]));
+  }
+  std::move(gathered.begin(), gathered.end(), column);
+}
+
+template <typename Iterator, typename... Symbols, typename... Values>
+void gather(Iterator first, std::vector<std::size_t> const &indices, type_constant<record<field<Symbols, Values>...>>)
+{
+  symbol_set<Symbols...>{ (gather_column(get(Symbols{}, first), indices, type_c<Values>), Symbols{})... };
+}
+
+///
+/// Rearrange the elements of a random access zip::iterator's sequences
+/// so that element i is moved from element indices[i]. Each column is
+/// permuted in one pass through a buffer, independently of the others.
+template <typename Iterator>
+void gather(Iterator first, std::vector<std::size_t> const &indices)
+{
+  using value_type = typename std::iterator_traits<Iterator>::value_type;
+  gather(first, indices, type_c<value_type>);
+}
+
+///
+/// A symbol whose rows are sorted in descending order; see sort_by()
+template <typename Symbol>
+struct descending
+{
+};
+
+///
+///     sort_by(zipped, account, -timestamp) // newest first within each account
+template <typename Symbol>
+constexpr descending<Symbol> operator-(symbol<Symbol> const &)
+{
+  return {};
+}
+
+template <typename Key>
+struct sort_key
+{
+  using symbol_type = Key;
+  static constexpr bool is_descending = false;
+};
+
+template <typename Symbol>
+struct sort_key<descending<Symbol>>
+{
+  using symbol_type = Symbol;
+  static constexpr bool is_descending = true;
+};
+
+template <bool Descending, typename ColumnIterator>
+struct sort_key_column
+{
+  ColumnIterator column;
+
+  using value_type = typename std::iterator_traits<ColumnIterator>::value_type;
+  using radix = radix_key<value_type>;
+};
+
+template <typename Key, typename Iterator>
+auto make_sort_key_column(Iterator first)
+{
+  auto column = get(typename sort_key<Key>::symbol_type{}, first);
+  return sort_key_column<sort_key<Key>::is_descending, decltype(column)>{ column };
+}
+
+///
+/// The smallest unsigned integer of 1, 2, 4 or 8 bytes which is at least n bytes (or void)
+template <std::size_t N>
+using packed_key_t = typename std::conditional_t<N <= 1, unsigned_of_size<1>,
+                                                 std::conditional_t<N <= 2, unsigned_of_size<2>,
+                                                                    std::conditional_t<N <= 4, unsigned_of_size<4>,
+                                                                                       std::conditional_t<N <= 8, unsigned_of_size<8>,
+                                                                                                          type_constant<void>>>>>::type;
+
+template <typename... KeyColumns>
+struct packs_into_word
+{
+  static constexpr bool radix = std::is_same<std::integer_sequence<bool, true, KeyColumns::radix::value...>,
+                                             std::integer_sequence<bool, KeyColumns::radix::value..., true>>::value;
+  static constexpr std::size_t bytes = sum_of({ sizeof(typename KeyColumns::value_type)... });
+  static constexpr bool value = radix && bytes <= 8;
+};
+
+// shifting by the whole width of an integer is undefined
+template <typename Unsigned>
+Unsigned shift_in(Unsigned word, std::size_t bits, Unsigned low)
+{
+  return (bits >= sizeof(Unsigned) * 8 ? Unsigned(0) : Unsigned(word << bits)) | low;
+}
+
+template <typename Unsigned, bool Descending, typename ColumnIterator>
+Unsigned encode_key(sort_key_column<Descending, ColumnIterator> const &c, std::size_t row)
+{
+  using radix = typename sort_key_column<Descending, ColumnIterator>::radix;
+  auto encoded = radix::encode(c.column[static_cast<std::ptrdiff_t>(row)]);
+  return static_cast<Unsigned>(Descending ? decltype(encoded)(~encoded) : encoded);
+}
+
+///
+/// Every key packs into one word: concatenate their radix encodings, most
+/// significant key first (complemented, for descending keys), and radix sort those
+template <typename... KeyColumns>
+void sort_permutation(std::vector<std::size_t> &indices, std::true_type /* packed */, KeyColumns const &... columns)
+{
+  using word_type = packed_key_t<packs_into_word<KeyColumns...>::bytes>;
+
+  std::vector<word_type> keys;
+  keys.reserve(indices.size());
+  for (auto i : indices)
+  {
+    word_type word = 0;
+    // key columns may have the same type, so they can't make a symbol_set
+    (void)std::initializer_list<int>{ (word = shift_in(word, sizeof(typename KeyColumns::value_type) * 8, encode_key<word_type>(columns, i)), 0)... };
+    keys.push_back(word);
+  }
+  radix_sort(keys, indices);
+}
+
+inline bool less_by_keys(std::size_t, std::size_t)
+{
+  return false;
+}
+
+template <bool Descending, typename ColumnIterator, typename... Rest>
+bool less_by_keys(std::size_t l, std::size_t r, sort_key_column<Descending, ColumnIterator> const &c, Rest const &... rest)
+{
+  auto const &a = c.column[static_cast<std::ptrdiff_t>(l)];
+  auto const &b = c.column[static_cast<std::ptrdiff_t>(r)];
+  if (a < b)
+  {
+    return !Descending;
+  }
+  if (b < a)
+  {
+    return Descending;
+  }
+  return less_by_keys(l, r, rest...);
+}
+
+///
+/// Otherwise, stable sort with one comparator which reads each key
+/// straight from its column, stopping at the first which differs
+template <typename... KeyColumns>
+void sort_permutation(std::vector<std::size_t> &indices, std::false_type /* packed */, KeyColumns const &... columns)
+{
+  std::stable_sort(indices.begin(), indices.end(), [&](std::size_t l, std::size_t r) {
+    return less_by_keys(l, r, columns...);
+  });
+}
+
+///
+/// Compute the permutation of row indices which stably sorts
+/// a random access zip::iterator's sequences by some keys.
+template <typename Iterator, typename... Keys>
+std::vector<std::size_t> sort_permutation(Iterator first, std::size_t n, Keys const &...)
+{
+  static_assert(sizeof...(Keys) != 0, "at least one key is required");
+  std::vector<std::size_t> indices(n);
+  std::iota(indices.begin(), indices.end(), std::size_t(0));
+  sort_permutation(indices, integer_c<bool, packs_into_word<decltype(make_sort_key_column<Keys>(first))...>::value>,
+                   make_sort_key_column<Keys>(first)...);
+  return indices;
+}
+
+///
+/// Stable sort of a random access zip::range (or columns) by one or
+/// more fields, compared lexicographically. Prefix a symbol with - to
+/// sort its field in descending order:
+///
+///     sort_by(zip(key = keys, a = as, b = bs), key);
+///     sort_by(zip(account = accounts, timestamp = timestamps), account, -timestamp);
+///
+/// Rather than moving every column on every swap, this sorts a permutation
+/// of row indices by the key columns alone then gathers each column through
+/// that permutation. If the keys are all integral, enum or floating point
+/// and fit in 64 bits together, they are packed into one integer per row
+/// and radix sorted.
+template <typename Range, typename... Keys>
+void sort_by(Range &&zipped, Keys const &... keys)
+{
+  auto first = zipped.begin();
+  auto n = static_cast<std::size_t>(zipped.end() - first);
+  auto indices = sort_permutation(first, n, keys...);
+  if (!std::is_sorted(indices.begin(), indices.end()))
+  {
+    gather(first, indices);
+  }
+}
+
+template <typename... KeyColumns>
+std::vector<std::size_t> select_top_k(std::size_t n, std::size_t k, KeyColumns const &... columns)
+{
+  k = std::min(k, n);
+  std::vector<std::size_t> heap(k);
+  std::iota(heap.begin(), heap.end(), std::size_t(0));
+
+  auto less = [&](std::size_t l, std::size_t r) {
+    return less_by_keys(l, r, columns...);
+  };
+  // ties go to the earlier row, as in a stable sort
+  auto before = [&](std::size_t l, std::size_t r) {
+    return less(l, r) || (!less(r, l) && l < r);
+  };
+
+  // heap.front() is the last of the rows kept so far; a later row
+  // replaces it only if its keys are strictly less
+  std::make_heap(heap.begin(), heap.end(), before);
+  for (std::size_t i = k; k != 0 && i != n; ++i)
+  {
+    if (less(i, heap.front()))
+    {
+      std::pop_heap(heap.begin(), heap.end(), before);
+      heap.back() = i;
+      std::push_heap(heap.begin(), heap.end(), before);
+    }
+  }
+  std::sort_heap(heap.begin(), heap.end(), before);
+  return heap;
+}
+
+///
+/// The indices of the first k rows (or all n, if fewer) of a random access
+/// zip::iterator's sequences in the order sort_permutation() would give.
+/// A heap of k row indices is kept, ordered by the key columns alone.
+template <typename Iterator, typename... Keys>
+std::vector<std::size_t> top_k_permutation(Iterator first, std::size_t n, std::size_t k, Keys const &...)
+{
+  static_assert(sizeof...(Keys) != 0, "at least one key is required");
+  return select_top_k(n, k, make_sort_key_column<Keys>(first)...);
+}
+
+template <typename Iterator, typename... Symbols, typename... Values>
+columns<record<field<Symbols, Values>...>> gather_rows(Iterator first, std::vector<std::size_t> const &indices,
+                                                       type_constant<record<field<Symbols, Values>...>>)
+{
+  columns<record<field<Symbols, Values>...>> rows;
+  rows.resize(indices.size());
+  symbol_set<Symbols...>{ (std::transform(indices.begin(), indices.end(), get(Symbols{}, rows).begin(),
+                                          [column = get(Symbols{}, first)](std::size_t i) { return column[static_cast<std::ptrdiff_t>(i)]; }),
+                           Symbols{})... };
+  return rows;
+}
+
+///
+/// Copies of the first k rows of a random access zip::range (or columns)
+/// in the order sort_by() would give them, without sorting or moving the
+/// range itself. Keys are as for sort_by(), so the k highest scores are
+///
+///     auto best = top_k(zip(id = ids, score = scores), 10, -score);
+///
+/// Only row indices move while the k rows are chosen, compared by the key
+/// columns alone; each column of the winners is then copied once.
+template <typename Range, typename... Keys>
+auto top_k(Range &&zipped, std::size_t k, Keys const &... keys)
+{
+  auto first = zipped.begin();
+  auto n = static_cast<std::size_t>(zipped.end() - first);
+  using value_type = typename std::iterator_traits<decltype(first)>::value_type;
+  return gather_rows(first, top_k_permutation(first, n, k, keys...), type_c<value_type>);
+}
+
+} // namespace
+} // namespace rekt
@@ -0,0 +1,69 @@
+/// Copyright (c) Benjamin Kietzman (github.com/bkietz)
+///
+/// Distributed under the Boost Software License, Version 1.0. (See accompanying
+/// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <cstddef>
+
+namespace rekt
+{
+namespace
+{
+
+///
+/// non-owning view of a contiguous sequence of Elements
+/// (the subset of C++20's std::span which zipped chunks need)
+template <typename Element>
+class span
+{
+public:
+  using element_type = Element;
+  using iterator = Element *;
+  using size_type = std::size_t;
+
+  constexpr span() = default;
+
+  constexpr span(Element *data, size_type size)
+      : data_{ data }, size_{ size }
+  {
+  }
+
+  constexpr Element *data() const
+  {
+    return data_;
+  }
+
+  constexpr size_type size() const
+  {
+    return size_;
+  }
+
+  constexpr bool empty() const
+  {
+    return size_ == 0;
+  }
+
+  constexpr Element &operator[](size_type i) const
+  {
+    return data_[i];
+  }
+
+  constexpr iterator begin() const
+  {
+    return data_;
+  }
+
+  constexpr iterator end() const
+  {
+    return data_ + size_;
+  }
+
+private:
+  Element *data_ = nullptr;
+  size_type size_ = 0;
+};
+
+} // namespace
+} // namespace rekt
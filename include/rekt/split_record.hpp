@@ -0,0 +1,177 @@
+/// Copyright (c) Benjamin Kietzman (github.com/bkietz)
+///
+/// Distributed under the Boost Software License, Version 1.0. (See accompanying
+/// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <memory>
+#include <rekt/columns.hpp>
+#include <rekt/record.hpp>
+
+namespace rekt
+{
+namespace
+{
+
+template <typename Hot, typename Cold>
+class split_record;
+
+///
+/// A record whose hot fields are stored inline and whose cold fields
+/// (read rarely: debug or audit data, say) are stored in a separately
+/// allocated block, so that a container of them keeps only the hot fields
+/// and one pointer per element in the cache:
+///
+///     using session = split_record<record<field<user_t, int>, field<expiry_t, long>>,
+///                                  record<field<user_agent_t, std::string>, field<audit_t, std::string>>>;
+///     session s{ { 7, 3600 }, { "curl"s, ""s } };
+///     user(s) == 7;            // inline
+///     user_agent(s) == "curl"; // through the pointer
+///
+/// get() works for hot and cold symbols alike. Copies copy the cold block;
+/// a moved-from split_record may only be assigned to or destroyed.
+template <typename... HotSymbols, typename... HotValues, typename... ColdSymbols, typename... ColdValues>
+class split_record<record<field<HotSymbols, HotValues>...>, record<field<ColdSymbols, ColdValues>...>>
+    : public record<field<HotSymbols, HotValues>...>
+{
+  static_assert(sizeof(symbol_set<HotSymbols..., ColdSymbols...>) != 0, "a field may be hot or cold but not both");
+
+public:
+  using hot_type = record<field<HotSymbols, HotValues>...>;
+  using cold_type = record<field<ColdSymbols, ColdValues>...>;
+
+  split_record()
+      : cold_{ new cold_type{} }
+  {
+  }
+
+  split_record(hot_type hot, cold_type cold)
+      : hot_type{ std::move(hot) }, cold_{ new cold_type{ std::move(cold) } }
+  {
+  }
+
+  split_record(split_record const &other)
+      : hot_type{ other.hot() }, cold_{ new cold_type{ other.cold() } }
+  {
+  }
+
+  split_record(split_record &&) = default;
+
+  split_record &operator=(split_record const &other)
+  {
+    if (cold_ == nullptr)
+    {
+      cold_.reset(new cold_type{ other.cold() });
+    }
+    else
+    {
+      cold() = other.cold();
+    }
+    hot() = other.hot();
+    return *this;
+  }
+
+  split_record &operator=(split_record &&) = default;
+
+  hot_type &hot()
+  {
+    return *this;
+  }
+
+  hot_type const &hot() const
+  {
+    return *this;
+  }
+
+  cold_type &cold()
+  {
+    return *cold_;
+  }
+
+  cold_type const &cold() const
+  {
+    return *cold_;
+  }
+
+  friend bool operator==(split_record const &l, split_record const &r)
+  {
+    return l.hot() == r.hot() && l.cold() == r.cold();
+  }
+
+  friend bool operator!=(split_record const &l, split_record const &r)
+  {
+    return !(l == r);
+  }
+
+private:
+  std::unique_ptr<cold_type> cold_;
+};
+
+// hot fields are found through the hot_type base, cold ones through these.
+// Symbols which both records have (like field_enum) aren't fields.
+template <typename Symbol, typename Hot, typename Cold>
+using enable_if_cold = std::enable_if_t<has<Symbol, Cold &> && !has<Symbol, Hot &>>;
+
+template <typename Symbol, typename Hot, typename Cold, typename = enable_if_cold<Symbol, Hot, Cold>>
+decltype(auto) get(Symbol const &s, split_record<Hot, Cold> &r)
+{
+  return get(s, r.cold());
+}
+
+template <typename Symbol, typename Hot, typename Cold, typename = enable_if_cold<Symbol, Hot, Cold>>
+decltype(auto) get(Symbol const &s, split_record<Hot, Cold> const &r)
+{
+  return get(s, r.cold());
+}
+
+template <typename Symbol, typename Hot, typename Cold, typename = enable_if_cold<Symbol, Hot, Cold>>
+decltype(auto) get(Symbol const &s, split_record<Hot, Cold> &&r)
+{
+  return get(s, std::move(r.cold()));
+}
+
+///
+/// Like make_record, from a record of hot fields and one of cold fields:
+///
+///     make_split_record(make_record(user = 7), make_record(user_agent = "curl"s))
+template <typename Hot, typename Cold>
+auto make_split_record(Hot &&hot, Cold &&cold)
+{
+  return split_record<std::decay_t<Hot>, std::decay_t<Cold>>{ std::forward<Hot>(hot), std::forward<Cold>(cold) };
+}
+
+template <typename... HotSymbols, typename... HotValues, typename... ColdSymbols, typename... ColdValues>
+constexpr auto get(struct field_enum const &,
+                   split_record<record<field<HotSymbols, HotValues>...>, record<field<ColdSymbols, ColdValues>...>> const &)
+{
+  return field_enum.make(symbol_set<HotSymbols..., ColdSymbols...>{}, index_sequence_for<HotSymbols..., ColdSymbols...>{});
+}
+
+template <typename... HotSymbols, typename... HotValues, typename... ColdSymbols, typename... ColdValues, typename Function>
+auto map(split_record<record<field<HotSymbols, HotValues>...>, record<field<ColdSymbols, ColdValues>...>> &rec, Function &&f)
+{
+  return map(rec, std::forward<Function>(f), symbol_set<HotSymbols..., ColdSymbols...>{});
+}
+
+template <typename... HotSymbols, typename... HotValues, typename... ColdSymbols, typename... ColdValues, typename Function>
+auto map(split_record<record<field<HotSymbols, HotValues>...>, record<field<ColdSymbols, ColdValues>...>> const &rec, Function &&f)
+{
+  return map(rec, std::forward<Function>(f), symbol_set<HotSymbols..., ColdSymbols...>{});
+}
+
+///
+/// columns already keep every field in a column of its own, so the cold
+/// fields of split_records are side columns which loops over hot fields
+/// never touch. push_back() and append() take split_records (or any
+/// record with all the fields).
+template <typename... HotSymbols, typename... HotValues, typename... ColdSymbols, typename... ColdValues, typename Allocator>
+class columns<split_record<record<field<HotSymbols, HotValues>...>, record<field<ColdSymbols, ColdValues>...>>, Allocator>
+    : public columns<record<field<HotSymbols, HotValues>..., field<ColdSymbols, ColdValues>...>, Allocator>
+{
+public:
+  using columns<record<field<HotSymbols, HotValues>..., field<ColdSymbols, ColdValues>...>, Allocator>::columns;
+};
+
+} // namespace
+} // namespace rekt
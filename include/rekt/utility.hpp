@@ -5,6 +5,7 @@
 
 #pragma once
 
+#include <initializer_list>
 #include <type_traits>
 #include <utility>
 
@@ -91,5 +92,27 @@ constexpr To static_cast_(type_constant<To>, From &&f)
   return static_cast<To>(std::forward<From>(f));
 }
 
+constexpr std::size_t sum_of(std::initializer_list<std::size_t> values)
+{
+  std::size_t sum = 0;
+  for (auto v : values)
+  {
+    sum += v;
+  }
+  return sum;
+}
+
+constexpr bool all_true(std::initializer_list<bool> values)
+{
+  for (auto v : values)
+  {
+    if (!v)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
 } // namespace
 } // namespace rekt
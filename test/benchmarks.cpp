@@ -0,0 +1,423 @@
+#include <rekt.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Not a test suite: prints timings for some operations on zipped ranges
+// next to their conventional counterparts.
+//
+//     benchmarks [rows]
+
+REKT_SYMBOLS(key, text, a, b, c, d, e, price, qty, fee, total);
+
+namespace
+{
+
+struct row
+{
+  int key;
+  std::string text;
+};
+
+template <typename Function>
+double time_ms(Function &&f)
+{
+  auto start = std::chrono::steady_clock::now();
+  f();
+  std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count();
+}
+
+void report(std::string const &name, double ms)
+{
+  std::cout << name << ": " << ms << " ms" << std::endl;
+}
+
+std::vector<int> shuffled_indices(std::size_t rows)
+{
+  std::vector<int> indices(rows);
+  for (std::size_t i = 0; i != rows; ++i)
+  {
+    indices[i] = static_cast<int>(i);
+  }
+  std::shuffle(indices.begin(), indices.end(), std::mt19937{ 42 });
+  return indices;
+}
+
+void sort_zipped_strings(std::size_t rows)
+{
+  auto indices = shuffled_indices(rows);
+  std::vector<std::string> strings;
+  std::vector<row> structs;
+  for (int i : indices)
+  {
+    // long enough to defeat the small string optimization
+    strings.push_back("a string for row number " + std::to_string(i));
+    structs.push_back(row{ i, strings.back() });
+  }
+
+  report("std::sort zip(key, text)", time_ms([&] {
+           auto zipped = rekt::zip(key = indices, text = strings);
+           std::sort(zipped.begin(), zipped.end(), [](auto const &l, auto const &r) {
+             return key(l) < key(r);
+           });
+         }));
+
+  auto sort_by_indices = shuffled_indices(rows);
+  std::vector<std::string> sort_by_strings;
+  for (int i : sort_by_indices)
+  {
+    sort_by_strings.push_back("a string for row number " + std::to_string(i));
+  }
+  report("rekt::sort_by zip(key, text)", time_ms([&] {
+           rekt::sort_by(rekt::zip(key = sort_by_indices, text = sort_by_strings), key);
+         }));
+
+  report("std::sort vector<struct>", time_ms([&] {
+           std::sort(structs.begin(), structs.end(), [](row const &l, row const &r) {
+             return l.key < r.key;
+           });
+         }));
+}
+
+void sort_wide_table(std::size_t rows)
+{
+  auto keys = shuffled_indices(rows);
+  std::vector<double> as(rows, 1.0), bs(rows, 2.0), cs(rows, 3.0), ds(rows, 4.0);
+  std::vector<std::string> es(rows, "a string for each row in the table");
+
+  auto std_keys = keys;
+  report("std::sort zip(key, a, b, c, d, e)", time_ms([&] {
+           auto zipped = rekt::zip(key = std_keys, a = as, b = bs, c = cs, d = ds, e = es);
+           std::sort(zipped.begin(), zipped.end(), [](auto const &l, auto const &r) {
+             return key(l) < key(r);
+           });
+         }));
+
+  std::shuffle(es.begin(), es.end(), std::mt19937{ 42 });
+  report("rekt::sort_by zip(key, a, b, c, d, e)", time_ms([&] {
+           rekt::sort_by(rekt::zip(key = keys, a = as, b = bs, c = cs, d = ds, e = es), key);
+         }));
+
+  // two keys: key / 16 ascending, then key descending
+  std::shuffle(keys.begin(), keys.end(), std::mt19937{ 7 });
+  std::vector<int> groups(rows);
+  std::transform(keys.begin(), keys.end(), groups.begin(), [](int k) { return k / 16; });
+  auto std_groups = groups;
+  std_keys = keys;
+  report("std::sort zip(fee, key, a, b, c, d) by fee, -key", time_ms([&] {
+           auto zipped = rekt::zip(fee = std_groups, key = std_keys, a = as, b = bs, c = cs, d = ds);
+           std::sort(zipped.begin(), zipped.end(), [](auto const &l, auto const &r) {
+             return fee(l) != fee(r) ? fee(l) < fee(r) : key(l) > key(r);
+           });
+         }));
+  report("rekt::sort_by zip(fee, key, a, b, c, d) by fee, -key", time_ms([&] {
+           rekt::sort_by(rekt::zip(fee = groups, key = keys, a = as, b = bs, c = cs, d = ds), fee, -key);
+         }));
+  if (keys != std_keys)
+  {
+    std::cout << "orders differ!" << std::endl;
+  }
+}
+
+void rank_candidates(std::size_t rows)
+{
+  auto keys = shuffled_indices(rows);
+  std::vector<double> as(rows, 1.0), bs(rows, 2.0), cs(rows, 3.0), ds(rows, 4.0);
+  std::size_t const k = 100;
+
+  auto std_keys = keys;
+  report("std::partial_sort zip(key, a, b, c, d), 100 highest", time_ms([&] {
+           auto zipped = rekt::zip(key = std_keys, a = as, b = bs, c = cs, d = ds);
+           std::partial_sort(zipped.begin(), zipped.begin() + k, zipped.end(), [](auto const &l, auto const &r) {
+             return key(l) > key(r);
+           });
+         }));
+
+  rekt::columns<rekt::record<rekt::field<struct key, int>, rekt::field<struct a, double>, rekt::field<struct b, double>,
+                             rekt::field<struct c, double>, rekt::field<struct d, double>>>
+      best;
+  report("rekt::top_k zip(key, a, b, c, d), 100 highest", time_ms([&] {
+           best = rekt::top_k(rekt::zip(key = keys, a = as, b = bs, c = cs, d = ds), k, -key);
+         }));
+  if (!std::equal(key(best).begin(), key(best).end(), std_keys.begin()))
+  {
+    std::cout << "winners differ!" << std::endl;
+  }
+}
+
+void scan_sessions(std::size_t rows)
+{
+  using hot = rekt::record<rekt::field<struct key, int>, rekt::field<struct price, double>>;
+  using cold = rekt::record<rekt::field<struct text, std::string>, rekt::field<struct a, double>, rekt::field<struct b, double>,
+                            rekt::field<struct c, double>, rekt::field<struct d, double>>;
+  std::vector<rekt::record<rekt::field<struct key, int>, rekt::field<struct price, double>, rekt::field<struct text, std::string>,
+                           rekt::field<struct a, double>, rekt::field<struct b, double>, rekt::field<struct c, double>,
+                           rekt::field<struct d, double>>>
+      wide;
+  std::vector<rekt::split_record<hot, cold>> split;
+  wide.reserve(rows);
+  split.reserve(rows);
+  for (std::size_t i = 0; i != rows; ++i)
+  {
+    wide.push_back({ static_cast<int>(i), 1.0, "", 1.0, 2.0, 3.0, 4.0 });
+    split.push_back({ { static_cast<int>(i), 1.0 }, { std::string{}, 1.0, 2.0, 3.0, 4.0 } });
+  }
+
+  double wide_total = 0, split_total = 0;
+  report("sum price over records with cold fields inline", time_ms([&] {
+           for (auto const &r : wide)
+           {
+             wide_total += price(r) * key(r);
+           }
+         }));
+  report("sum price over split_records", time_ms([&] {
+           for (auto const &r : split)
+           {
+             split_total += price(r) * key(r);
+           }
+         }));
+  if (wide_total != split_total)
+  {
+    std::cout << "totals differ!" << std::endl;
+  }
+}
+
+void price_columns(std::size_t rows)
+{
+  std::vector<double> prices(rows, 1.25), fees(rows, 0.5), totals(rows);
+  std::vector<int> qtys(rows, 3);
+
+  report("for (auto r : zip(price, qty, fee, total))", time_ms([&] {
+           for (auto r : rekt::zip(price = prices, qty = qtys, fee = fees, total = totals))
+           {
+             total(r) = price(r) * qty(r) - fee(r);
+           }
+         }));
+
+  report("rekt::simd::transform zip(price, qty, fee)", time_ms([&] {
+           rekt::simd::transform(rekt::zip(price = prices, qty = qtys, fee = fees), total = totals, [](auto p, auto q, auto f) {
+             return p * q - f;
+           });
+         }));
+}
+
+void join_prices(std::size_t rows)
+{
+  // every left row matches one of rows / 4 right rows
+  auto left_keys = shuffled_indices(rows);
+  std::vector<double> prices(rows, 1.25);
+  for (auto &k : left_keys)
+  {
+    k /= 4;
+  }
+  auto right_keys = shuffled_indices(rows / 4 + 1);
+  std::vector<int> qtys(right_keys.size(), 3);
+
+  double std_total = 0;
+  report("std::unordered_map<int, std::size_t> join", time_ms([&] {
+           std::unordered_map<int, std::size_t> rows_by_key;
+           for (std::size_t i = 0; i != right_keys.size(); ++i)
+           {
+             rows_by_key.emplace(right_keys[i], i);
+           }
+           for (std::size_t i = 0; i != left_keys.size(); ++i)
+           {
+             auto found = rows_by_key.find(left_keys[i]);
+             if (found != rows_by_key.end())
+             {
+               std_total += prices[i] * qtys[found->second];
+             }
+           }
+         }));
+
+  double rekt_total = 0;
+  report("rekt::hash_join zip(key, price) zip(key, qty)", time_ms([&] {
+           for (auto r : rekt::hash_join(rekt::zip(key = left_keys, price = prices), rekt::zip(key = right_keys, qty = qtys), key))
+           {
+             rekt_total += price(r) * qty(r);
+           }
+         }));
+
+  if (std_total != rekt_total)
+  {
+    std::cout << "totals differ!" << std::endl;
+  }
+
+  std::sort(left_keys.begin(), left_keys.end());
+  std::sort(right_keys.begin(), right_keys.end());
+  report("rekt::hash_join sorted zip(key, price) zip(key, qty)", time_ms([&] {
+           for (auto r : rekt::hash_join(rekt::zip(key = left_keys, price = prices), rekt::zip(key = right_keys, qty = qtys), key))
+           {
+             rekt_total -= price(r) * qty(r);
+           }
+         }));
+  report("rekt::merge_join sorted zip(key, price) zip(key, qty)", time_ms([&] {
+           for (auto r : rekt::merge_join(rekt::zip(key = left_keys, price = prices), rekt::zip(key = right_keys, qty = qtys), key))
+           {
+             rekt_total += price(r) * qty(r);
+           }
+         }));
+}
+
+void rollup_prices(std::size_t rows)
+{
+  auto keys = shuffled_indices(rows);
+  for (auto &k : keys)
+  {
+    k %= 10000;
+  }
+  std::vector<double> prices(rows, 1.25);
+
+  report("std::unordered_map<int, sum, count, max> rollup", time_ms([&] {
+           struct rollup
+           {
+             double total = 0;
+             std::size_t n = 0;
+             double hi = -1e300;
+           };
+           std::unordered_map<int, rollup> rollups;
+           for (std::size_t i = 0; i != rows; ++i)
+           {
+             auto &r = rollups[keys[i]];
+             r.total += prices[i];
+             ++r.n;
+             r.hi = std::max(r.hi, prices[i]);
+           }
+         }));
+
+  report("rekt::group_by zip(key, price) sum, count, max", time_ms([&] {
+           rekt::group_by(rekt::zip(key = keys, price = prices), key)
+               .aggregate(total = rekt::sum(price), a = rekt::count(), b = rekt::max(price));
+         }));
+
+  std::vector<int> qtys(rows);
+  std::transform(keys.begin(), keys.end(), qtys.begin(), [](int k) { return k % 7; });
+  std::size_t std_distinct = 0, rekt_distinct = 0;
+  report("std::unordered_set<int> of key * 7 + qty, first rows", time_ms([&] {
+           std::unordered_set<int> seen;
+           std::vector<std::size_t> firsts;
+           for (std::size_t i = 0; i != rows; ++i)
+           {
+             if (seen.insert(keys[i] * 7 + qtys[i]).second)
+             {
+               firsts.push_back(i);
+             }
+           }
+           std_distinct = firsts.size();
+         }));
+  report("rekt::distinct zip(key, qty, price) by key, qty", time_ms([&] {
+           rekt_distinct = rekt::distinct(rekt::zip(key = keys, qty = qtys, price = prices), key, qty).size();
+         }));
+  if (std_distinct != rekt_distinct)
+  {
+    std::cout << "distinct counts differ!" << std::endl;
+  }
+}
+
+void filter_prices(std::size_t rows)
+{
+  auto keys = shuffled_indices(rows);
+  std::vector<double> prices(rows, 1.25);
+
+  double std_total = 0;
+  report("copy_if rows then sum", time_ms([&] {
+           std::vector<std::size_t> kept;
+           for (std::size_t i = 0; i != rows; ++i)
+           {
+             if (keys[i] % 3 == 0)
+             {
+               kept.push_back(i);
+             }
+           }
+           for (auto i : kept)
+           {
+             std_total += prices[i];
+           }
+         }));
+
+  double rekt_total = 0;
+  report("zip(key, price) | where | select(price)", time_ms([&] {
+           (rekt::zip(key = keys, price = prices)
+                | rekt::where([](auto &&r) { return key(r) % 3 == 0; })
+                | rekt::select(price))
+               .for_each([&](auto &&r) { rekt_total += price(r); });
+         }));
+
+  if (std_total != rekt_total)
+  {
+    std::cout << "totals differ!" << std::endl;
+  }
+
+  std::size_t lambda_count = 0, bitmap_count = 0;
+  report("count_if(zip(key, price), lambda)", time_ms([&] {
+           auto zipped = rekt::zip(key = keys, price = prices);
+           lambda_count = static_cast<std::size_t>(std::count_if(zipped.begin(), zipped.end(), [](auto &&r) {
+             return key(r) > 1000 && price(r) < 2.0;
+           }));
+         }));
+  report("where(zip(key, price), key > 1000 && price < 2.0)", time_ms([&] {
+           bitmap_count = rekt::where(rekt::zip(key = keys, price = prices), key > 1000 && price < 2.0).count();
+         }));
+
+  if (lambda_count != bitmap_count)
+  {
+    std::cout << "counts differ!" << std::endl;
+  }
+}
+
+void late_materialization(std::size_t rows)
+{
+  auto keys = shuffled_indices(rows);
+  std::vector<double> as(rows, 1.0), bs(rows, 2.0), cs(rows, 3.0), ds(rows, 4.0);
+  std::vector<std::string> es(rows, "a string for each row in the table");
+  auto table = rekt::zip(key = keys, a = as, b = bs, c = cs, d = ds, e = es);
+  using row_type = decltype(table)::iterator::value_type;
+
+  std::vector<row_type> copied;
+  report("copy rows where key < rows / 10", time_ms([&] {
+           for (auto r : table)
+           {
+             if (key(r) < static_cast<int>(rows / 10))
+             {
+               copied.push_back(r);
+             }
+           }
+         }));
+
+  std::size_t materialized = 0;
+  report("materialize(zip(key, a, b, c, d, e), key < rows / 10, key, a)", time_ms([&] {
+           auto selected = rekt::materialize(table, rekt::selection(rekt::where(table, key < static_cast<int>(rows / 10))), key, a);
+           materialized = selected.size();
+         }));
+
+  if (copied.size() != materialized)
+  {
+    std::cout << "counts differ!" << std::endl;
+  }
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+  std::size_t rows = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+  std::cout << rows << " rows" << std::endl;
+
+  sort_zipped_strings(rows);
+  sort_wide_table(rows);
+  rank_candidates(rows);
+  scan_sessions(rows);
+  price_columns(rows);
+  join_prices(rows);
+  rollup_prices(rows);
+  filter_prices(rows);
+  late_materialization(rows);
+}
@@ -2,10 +2,18 @@
 #include <catch.hpp>
 #include <rekt.hpp>
 
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <atomic>
 #include <iostream>
+#include <list>
 #include <nlohmann/json.hpp>
+#include <numeric>
 #include <string>
 #include <unordered_map>
+#include <unistd.h>
 #include <vector>
 
 REKT_SYMBOLS(height, width, label, dont);
@@ -332,3 +340,1258 @@ TEST_CASE("iteration")
     REQUIRE(string(r) == expected(r));
   }
 }
+
+TEST_CASE("zipping temporaries")
+{
+  REKT_SYMBOLS(index, string);
+  std::vector<std::string> strings{ "world", "!", "hello" };
+
+  auto zipped = rekt::zip(index = std::vector<int>{ 1, 2, 0 }, string = strings);
+  static_assert(std::is_same<decltype(index(zipped)), std::vector<int> &>(), "temporaries are owned");
+  static_assert(std::is_same<decltype(zipped), rekt::zip::range<rekt::record<
+                                                   rekt::field<struct index, std::vector<int>>,
+                                                   rekt::field<struct string, std::vector<std::string> &>>>>(),
+                "lvalues are referenced");
+  REQUIRE(&string(zipped) == &strings);
+
+  std::sort(zipped.begin(), zipped.end(), [&](auto const &l, auto const &r) {
+    return index(l) < index(r);
+  });
+  REQUIRE(index(zipped) == (std::vector<int>{ 0, 1, 2 }));
+  REQUIRE(strings == (std::vector<std::string>{ "hello", "world", "!" }));
+
+  // braced lists become owned std::arrays
+  int total = 0;
+  for (auto r : rekt::zip(index = { 1, 2, 3 }, string = strings))
+  {
+    total += index(r) * static_cast<int>(string(r).size());
+  }
+  REQUIRE(total == 1 * 5 + 2 * 5 + 3 * 1);
+}
+
+TEST_CASE("contiguous iteration")
+{
+  REKT_SYMBOLS(index, value);
+  std::vector<int> indices{ 3, 1, 2, 0 };
+  std::array<double, 5> values{ { 0.3, 0.1, 0.2, 0.0, 9.9 } };
+
+  auto zipped = rekt::zip(index = indices, value = values);
+  using iterator = decltype(zipped.begin());
+  static_assert(std::is_same<decltype(zipped)::iterator_category, rekt::zip::contiguous_iterator_tag>(),
+                "vectors and arrays are zipped by pointer");
+  static_assert(std::is_same<std::iterator_traits<iterator>::iterator_category, std::random_access_iterator_tag>(),
+                "but look like any other random access iterator");
+
+  // the shorter sequence determines the length
+  REQUIRE(zipped.end() - zipped.begin() == 4);
+  REQUIRE(value(zipped.begin()[2]) == 0.2);
+  REQUIRE(zipped.begin() + 4 == zipped.end());
+  REQUIRE(zipped.begin() < zipped.end());
+
+  std::sort(zipped.begin(), zipped.end(), [&](auto const &l, auto const &r) {
+    return index(l) < index(r);
+  });
+  REQUIRE(indices == (std::vector<int>{ 0, 1, 2, 3 }));
+  REQUIRE(values == (std::array<double, 5>{ { 0.0, 0.1, 0.2, 0.3, 9.9 } }));
+
+  // a deque isn't contiguous, so this uses the general random access iterator
+  std::deque<int> deque_indices{ 1, 0 };
+  auto mixed = rekt::zip(index = deque_indices, value = values);
+  static_assert(std::is_same<decltype(mixed)::iterator_category, std::random_access_iterator_tag>(), "");
+  std::sort(mixed.begin(), mixed.end(), [&](auto const &l, auto const &r) {
+    return index(l) < index(r);
+  });
+  REQUIRE(values[0] == 0.1);
+  REQUIRE(values[1] == 0.0);
+}
+
+TEST_CASE("swapping zipped elements")
+{
+  REKT_SYMBOLS(index, string, flag, handle);
+
+  SECTION("field-wise swap")
+  {
+    std::vector<int> indices{ 1, 0 };
+    // long enough to defeat the small string optimization
+    std::vector<std::string> strings{ "world, world, world, world", "hello, hello, hello, hello" };
+    std::vector<bool> flags{ true, false }; // proxy references
+    auto zipped = rekt::zip(index = indices, string = strings, flag = flags);
+
+    auto const *hello = strings[1].data();
+    swap(*zipped.begin(), *std::next(zipped.begin()));
+    REQUIRE(indices == (std::vector<int>{ 0, 1 }));
+    REQUIRE(strings == (std::vector<std::string>{ "hello, hello, hello, hello", "world, world, world, world" }));
+    REQUIRE(flags == (std::vector<bool>{ false, true }));
+    REQUIRE(strings[0].data() == hello); // swapped, not copied
+  }
+
+  SECTION("reading elements copies them")
+  {
+    std::vector<int> indices{ 0, 1 };
+    std::vector<std::string> strings{ "hello, hello, hello, hello", "world, world, world, world" };
+    auto zipped = rekt::zip(index = indices, string = strings);
+
+    decltype(zipped)::iterator::value_type first = *zipped.begin();
+    std::vector<decltype(zipped)::iterator::value_type> copy(zipped.begin(), zipped.end());
+    REQUIRE(string(first) == "hello, hello, hello, hello");
+    REQUIRE(string(copy[1]) == "world, world, world, world");
+    REQUIRE(strings == (std::vector<std::string>{ "hello, hello, hello, hello", "world, world, world, world" }));
+  }
+
+  SECTION("move only elements")
+  {
+    std::vector<int> indices{ 2, 0, 1 };
+    std::vector<move_only> handles;
+    handles.emplace_back("c");
+    handles.emplace_back("a");
+    handles.emplace_back("b");
+
+    auto zipped = rekt::zip(index = indices, handle = handles);
+    rekt::sort_by(zipped, index);
+    REQUIRE(handles[0].name() == "a");
+    REQUIRE(handles[1].name() == "b");
+    REQUIRE(handles[2].name() == "c");
+
+    swap(*zipped.begin(), *std::next(zipped.begin()));
+    REQUIRE(handles[0].name() == "b");
+    swap(*zipped.begin(), *std::next(zipped.begin()));
+
+    decltype(zipped)::iterator::value_type moved = iter_move(*zipped.begin());
+    REQUIRE(handle(moved).name() == "a");
+    REQUIRE(handles[0].name() == "<moved>");
+  }
+}
+
+TEST_CASE("sized zip")
+{
+  REKT_SYMBOLS(index, value);
+  std::deque<int> indices{ 2, 0, 1 };
+  std::vector<double> values{ 0.2, 0.0, 0.1 };
+
+  SECTION("size of an unsized range")
+  {
+    std::vector<double> longer{ 1, 2, 3, 4 };
+    auto zipped = rekt::zip(index = indices, value = longer);
+    REQUIRE(zipped.size() == 3);
+    REQUIRE(!zipped.empty());
+    REQUIRE(rekt::zip(value = std::vector<double>{}).empty());
+  }
+
+  SECTION("random access")
+  {
+    auto zipped = rekt::zip.sized(index = indices, value = values);
+    using iterator = decltype(zipped.begin());
+    static_assert(std::is_same<std::iterator_traits<iterator>::iterator_category, std::random_access_iterator_tag>(), "");
+    REQUIRE(zipped.size() == 3);
+    REQUIRE(zipped.end() - zipped.begin() == 3);
+    REQUIRE(zipped.end().count() == 3);
+
+    std::sort(zipped.begin(), zipped.end(), [&](auto const &l, auto const &r) {
+      return index(l) < index(r);
+    });
+    REQUIRE(values == (std::vector<double>{ 0.0, 0.1, 0.2 }));
+  }
+
+  SECTION("bidirectional")
+  {
+    std::list<int> listed{ 3, 4, 5 };
+    int total = 0;
+    for (auto r : rekt::zip.sized(index = listed, value = values))
+    {
+      total += index(r);
+    }
+    REQUIRE(total == 12);
+  }
+
+  SECTION("contiguous")
+  {
+    std::vector<int> vector_indices{ 1, 2, 3 };
+    auto zipped = rekt::zip.sized(index = vector_indices, value = values);
+    static_assert(std::is_same<decltype(zipped.begin()), decltype(rekt::zip(index = vector_indices, value = values).begin())>(),
+                  "contiguous iterators are not wrapped");
+    REQUIRE(zipped.size() == 3);
+  }
+
+  SECTION("ragged")
+  {
+    values.push_back(0.3);
+    REQUIRE_THROWS_AS(rekt::zip.sized(index = indices, value = values), std::length_error const &);
+  }
+}
+
+TEST_CASE("chunks")
+{
+  REKT_SYMBOLS(price, qty);
+  std::vector<double> prices{ 1, 2, 3, 4, 5, 6, 7 };
+  std::array<int, 7> qtys{ { 7, 6, 5, 4, 3, 2, 1 } };
+
+  auto chunks = rekt::zip(price = prices, qty = qtys).chunks(3);
+  REQUIRE(chunks.size() == 3);
+
+  static_assert(std::is_same<decltype(chunks)::value_type,
+                             rekt::record<rekt::field<struct price, rekt::span<double>>,
+                                          rekt::field<struct qty, rekt::span<int>>>>(),
+                "chunks are records of spans");
+
+  std::vector<std::size_t> sizes;
+  double total = 0;
+  for (auto chunk : chunks)
+  {
+    REQUIRE(price(chunk).size() == qty(chunk).size());
+    sizes.push_back(price(chunk).size());
+    for (std::size_t i = 0; i != price(chunk).size(); ++i)
+    {
+      total += price(chunk)[i] * qty(chunk)[i];
+    }
+  }
+  REQUIRE(sizes == (std::vector<std::size_t>{ 3, 3, 1 }));
+  REQUIRE(total == 1 * 7 + 2 * 6 + 3 * 5 + 4 * 4 + 5 * 3 + 6 * 2 + 7 * 1);
+
+  // writable
+  qty(chunks[2])[0] = 100;
+  REQUIRE(qtys[6] == 100);
+  REQUIRE(price(chunks[1]).data() == prices.data() + 3);
+
+  rekt::columns<rekt::record<rekt::field<struct price, double>>> cols(10);
+  auto const &ccols = cols;
+  static_assert(std::is_same<decltype(price(ccols.chunks(4)[0])), rekt::span<double const> &&>(), "const chunks");
+  REQUIRE(ccols.chunks(4).size() == 3);
+  auto owning = rekt::zip(price = std::vector<double>{});
+  REQUIRE(owning.chunks(4).empty());
+  REQUIRE_THROWS_AS(cols.chunks(0), std::invalid_argument const &);
+}
+
+TEST_CASE("columns")
+{
+  REKT_SYMBOLS(price, qty, note);
+  rekt::columns<rekt::record<
+      rekt::field<struct price, double>,
+      rekt::field<struct qty, int>,
+      rekt::field<struct note, std::string>>>
+      cols;
+
+  cols.reserve(3);
+  cols.push_back(rekt::make_record(price = 2.5, qty = 4, note = "b"s));
+  cols.push_back(rekt::make_record(note = "c"s, qty = 1, price = 0.5)); // field order doesn't matter
+  cols.push_back(rekt::make_record(price = 1.5, qty = 2, note = "a"s));
+
+  static_assert(std::is_same<decltype(price(cols)), std::vector<double> &>(), "one buffer per symbol");
+  REQUIRE(cols.size() == 3);
+  REQUIRE(qty(cols) == (std::vector<int>{ 4, 1, 2 }));
+
+  auto second = cols[1];
+  qty(second) = 7;
+  REQUIRE(qty(cols)[1] == 7);
+  REQUIRE(note(cols[2]) == "a");
+
+  std::sort(cols.begin(), cols.end(), [&](auto const &l, auto const &r) {
+    return price(l) < price(r);
+  });
+  REQUIRE(note(cols) == (std::vector<std::string>{ "c", "a", "b" }));
+
+  std::vector<std::string> expected{ "c", "a", "b" };
+  REKT_SYMBOLS(expect);
+  for (auto r : rekt::zip(note = note(cols), expect = expected))
+  {
+    REQUIRE(note(r) == expect(r));
+  }
+
+  double total = 0;
+  for (auto r : cols)
+  {
+    total += price(r) * qty(r);
+  }
+  REQUIRE(total == 0.5 * 7 + 1.5 * 2 + 2.5 * 4);
+
+  cols.resize(5);
+  REQUIRE(cols.size() == 5);
+  REQUIRE(note(cols[4]).empty());
+
+  auto const &ccols = cols;
+  auto first = ccols[0];
+  static_assert(std::is_same<decltype(price(first)), double const &>(), "const access");
+  REQUIRE(price(first) == 0.5);
+}
+
+TEST_CASE("sort_by")
+{
+  REKT_SYMBOLS(key, name, weight);
+
+  SECTION("integral keys")
+  {
+    std::vector<int> keys{ 3, -1, 2, -1, 0, 1000 };
+    std::vector<std::string> names{ "d", "a", "c", "b", "z", "e" };
+    std::deque<double> weights{ 0.3, 0.1, 0.2, 0.15, 0.0, 4 };
+
+    rekt::sort_by(rekt::zip(key = keys, name = names, weight = weights), key);
+    REQUIRE(keys == (std::vector<int>{ -1, -1, 0, 2, 3, 1000 }));
+    REQUIRE(names == (std::vector<std::string>{ "a", "b", "z", "c", "d", "e" })); // stable
+    REQUIRE(weights == (std::deque<double>{ 0.1, 0.15, 0.0, 0.2, 0.3, 4 }));
+  }
+
+  SECTION("floating point keys")
+  {
+    std::vector<double> weights{ 2.5, -0.5, 1e10, -3e-3, 0 };
+    std::vector<int> keys{ 0, 1, 2, 3, 4 };
+
+    rekt::sort_by(rekt::zip(key = keys, weight = weights), weight);
+    REQUIRE(weights == (std::vector<double>{ -0.5, -3e-3, 0, 2.5, 1e10 }));
+    REQUIRE(keys == (std::vector<int>{ 1, 3, 4, 0, 2 }));
+  }
+
+  SECTION("other keys")
+  {
+    std::vector<std::string> names{ "c", "a", "b" };
+    std::vector<int> keys{ 0, 1, 2 };
+
+    rekt::sort_by(rekt::zip(key = keys, name = names), name);
+    REQUIRE(names == (std::vector<std::string>{ "a", "b", "c" }));
+    REQUIRE(keys == (std::vector<int>{ 1, 2, 0 }));
+  }
+
+  SECTION("columns")
+  {
+    rekt::columns<rekt::record<rekt::field<struct key, unsigned char>, rekt::field<struct name, std::string>>> cols;
+    cols.push_back(rekt::make_record(key = (unsigned char)200, name = "b"s));
+    cols.push_back(rekt::make_record(key = (unsigned char)7, name = "a"s));
+
+    rekt::sort_by(cols, key);
+    REQUIRE(name(cols) == (std::vector<std::string>{ "a", "b" }));
+  }
+}
+
+TEST_CASE("query")
+{
+  REKT_SYMBOLS(name, score, rank);
+  std::vector<std::string> names{ "a", "b", "c", "d", "e", "f" };
+  std::vector<double> scores{ 0.9, 0.1, 0.7, 0.8, 0.2, 0.6 };
+  std::list<int> ranks{ 1, 2, 3, 4, 5, 6 };
+
+  auto good = rekt::zip(name = names, score = scores, rank = ranks) | rekt::where([&](auto &&r) { return score(r) > 0.5; });
+  REQUIRE(good.count() == 4);
+
+  std::vector<std::string> picked;
+  (std::move(good) | rekt::drop_n(1) | rekt::select(name, rank) | rekt::take_n(2)).for_each([&](auto &&r) {
+    static_assert(std::is_same<std::decay_t<decltype(r)>,
+                               rekt::record<rekt::field<struct name, std::string &>, rekt::field<struct rank, int &>>>(),
+                  "select takes references to the selected fields");
+    picked.push_back(name(r));
+    rank(r) *= 10;
+  });
+  REQUIRE(picked == (std::vector<std::string>{ "c", "d" }));
+  REQUIRE(ranks == (std::list<int>{ 1, 2, 30, 40, 5, 6 }));
+
+  // stops reading rows as soon as no more are wanted
+  std::size_t tested = 0;
+  auto counted = [&](auto &&r) { return ++tested, score(r) > 0.5; };
+  REQUIRE((rekt::zip(score = scores) | rekt::where(counted) | rekt::take_n(2)).count() == 2);
+  REQUIRE(tested == 3);
+  REQUIRE((rekt::zip(score = scores) | rekt::take_while([&](auto &&r) { return score(r) > 0.5; })).count() == 1);
+  REQUIRE((rekt::zip(score = scores) | rekt::take_n(0)).count() == 0);
+
+  // queries can be run more than once, and materialized
+  auto top = rekt::zip(name = names, score = scores) | rekt::where([&](auto &&r) { return score(r) > 0.75; });
+  rekt::columns<rekt::record<rekt::field<struct name, std::string>, rekt::field<struct score, double>>> cols;
+  top.into(cols);
+  top.into(cols);
+  REQUIRE(name(cols) == (std::vector<std::string>{ "a", "d", "a", "d" }));
+}
+
+TEST_CASE("expressions")
+{
+  REKT_SYMBOLS(age, height, name);
+  std::vector<int> ages;
+  std::vector<double> heights;
+  std::list<std::string> names;
+  for (int i = 0; i != 5000; ++i)
+  {
+    ages.push_back(i % 40);
+    heights.push_back(1.5 + (i % 7) * 0.1);
+    names.push_back(i % 3 == 0 ? "fizz" : "buzz");
+  }
+  auto people = rekt::zip(age = ages, height = heights, name = names);
+
+  auto e = age > 18 && !(2.0 <= height) || name == "fizz";
+  auto selected = rekt::where(people, e);
+  REQUIRE(selected.size() == 5000);
+
+  // the same as evaluating row by row
+  bool same = true;
+  std::size_t expected = 0, i = 0;
+  for (auto r : people)
+  {
+    bool row = (age(r) > 18 && height(r) < 2.0) || name(r) == "fizz";
+    same = same && e(r) == row && selected.test(i++) == row;
+    expected += row;
+  }
+  REQUIRE(same);
+  REQUIRE(selected.count() == expected);
+  REQUIRE((people | rekt::where(e)).count() == expected);
+
+  // bits past the end stay clear, even through negation
+  auto few = rekt::where(rekt::zip(age = std::vector<int>{ 1, 2, 3 }), !(age == 2));
+  REQUIRE(few.count() == 2);
+  REQUIRE(few.words()[0] == 5);
+
+  // == and != between symbols still compare symbols
+  static_assert(decltype(age == age)::value && !decltype(age == height)::value, "");
+}
+
+TEST_CASE("selection")
+{
+  REKT_SYMBOLS(age, city, name, n);
+  std::vector<int> ages;
+  std::vector<int> cities;
+  std::vector<std::string> names;
+  for (int i = 0; i != 1000; ++i)
+  {
+    ages.push_back(i % 50);
+    cities.push_back(i % 3);
+    names.push_back(std::to_string(i));
+  }
+  auto people = rekt::zip(age = ages, city = cities, name = names);
+
+  rekt::selection dense(rekt::where(people, age >= 25));
+  rekt::selection sparse(rekt::where(people, age == 7));
+  REQUIRE(dense.dense());
+  REQUIRE(!sparse.dense());
+  REQUIRE(dense.size() == 500);
+  REQUIRE(sparse.size() == 20);
+  REQUIRE(sparse.test(507));
+  REQUIRE(!sparse.test(508));
+
+  // both iterate selected row numbers in order
+  std::vector<std::size_t> rows(sparse.begin(), sparse.end());
+  REQUIRE(rows.size() == 20);
+  REQUIRE(rows[1] == 57);
+  std::size_t previous = 0, visited = 0;
+  bool ascending = true, selected = true;
+  for (auto row : dense)
+  {
+    ascending = ascending && (visited == 0 || row > previous);
+    selected = selected && ages[row] >= 25;
+    previous = row;
+    ++visited;
+  }
+  REQUIRE((ascending && selected && visited == 500));
+
+  // filtered ranges are respected by iteration and aggregation
+  std::size_t adults = 0;
+  for (auto r : rekt::filter(people, dense))
+  {
+    adults += age(r) >= 25;
+  }
+  REQUIRE(adults == 500);
+  auto by_city = rekt::group_by(rekt::filter(people, age == 7), city).aggregate(n = rekt::count());
+  REQUIRE(by_city.size() == 3);
+  REQUIRE(std::accumulate(n(by_city).begin(), n(by_city).end(), std::size_t(0)) == 20);
+
+  // materialize copies only the selected rows of the requested columns
+  auto sevens = rekt::materialize(people, sparse, name);
+  static_assert(std::is_same<decltype(sevens), rekt::columns<rekt::record<rekt::field<struct name, std::string>>>>(), "");
+  REQUIRE(name(sevens)[1] == "57");
+  auto all = rekt::materialize(people, sparse);
+  REQUIRE(all.size() == 20);
+  REQUIRE(city(all)[1] == 57 % 3);
+
+  // a filtered range can be the left (probe) side of a hash_join
+  std::vector<int> one_city{ 1 }, city_sizes{ 42 };
+  std::size_t joined = 0;
+  for (auto row : rekt::hash_join(rekt::filter(people, sparse), rekt::zip(city = one_city, n = city_sizes), city))
+  {
+    joined += age(row) == 7 && city(row) == 1 && n(row) == 42;
+  }
+  REQUIRE(joined == static_cast<std::size_t>(std::count_if(rows.begin(), rows.end(), [&](std::size_t r) { return cities[r] == 1; })));
+
+  REQUIRE_THROWS_AS(rekt::filter(rekt::zip(age = std::vector<int>(3)), sparse), std::length_error const &);
+  REQUIRE(rekt::selection(rekt::bitmap(0)).begin() == rekt::selection(rekt::bitmap(0)).end());
+}
+
+TEST_CASE("hash_join")
+{
+  REKT_SYMBOLS(id, price, qty);
+  std::vector<int> left_ids{ 1, 2, 3, 4, 2 };
+  std::vector<double> prices{ 10, 20, 30, 40, 50 };
+  std::list<long> right_ids{ 2, 4, 5, 2 };
+  std::vector<int> qtys{ 1, 2, 3, 4 };
+  std::vector<long> right_id_vector(right_ids.begin(), right_ids.end());
+
+  auto joined = rekt::hash_join(rekt::zip(id = left_ids, price = prices),
+                                rekt::zip(id = right_id_vector, qty = qtys), id);
+
+  std::vector<std::tuple<int, double, int>> rows;
+  for (auto row : joined)
+  {
+    rows.emplace_back(id(row), price(row), qty(row));
+  }
+  // left order, then right order among duplicates
+  REQUIRE(rows == (std::vector<std::tuple<int, double, int>>{
+                      { 2, 20, 1 }, { 2, 20, 4 }, { 4, 40, 2 }, { 2, 50, 1 }, { 2, 50, 4 } }));
+
+  // id is taken from the left, and fields are references into the columns
+  auto first = *joined.begin();
+  static_assert(std::is_same<decltype(id(first)), int &>(), "id comes from the left");
+  qty(first) = 100;
+  REQUIRE(qtys[0] == 100);
+
+  // a forward range on the left, columns (owned by the join) on the right
+  rekt::columns<rekt::record<rekt::field<struct id, long>, rekt::field<struct qty, int>>> right;
+  right.push_back(rekt::make_record(id = 5L, qty = 7));
+  std::list<int> listed_qtys{ 0, 0, 0, 0 };
+  double total = 0;
+  for (auto row : rekt::hash_join(rekt::zip(id = right_ids, price = listed_qtys), std::move(right), id))
+  {
+    total += qty(row);
+  }
+  REQUIRE(total == 7);
+
+  std::vector<int> none;
+  REQUIRE(rekt::hash_join(rekt::zip(id = left_ids), rekt::zip(id = none), id).begin() ==
+          rekt::hash_join(rekt::zip(id = left_ids), rekt::zip(id = none), id).end());
+}
+
+TEST_CASE("merge_join")
+{
+  REKT_SYMBOLS(id, price, qty);
+  std::vector<int> left_ids{ 1, 2, 2, 3, 5, 8, 9, 9 };
+  std::vector<double> prices{ 1, 2, 3, 4, 5, 6, 7, 8 };
+  std::vector<long> right_ids{ 0, 2, 2, 4, 5, 6, 7, 9 };
+  std::vector<int> qtys{ 0, 1, 2, 3, 4, 5, 6, 7 };
+
+  std::vector<std::tuple<int, double, int>> rows;
+  for (auto row : rekt::merge_join(rekt::zip(id = left_ids, price = prices), rekt::zip(id = right_ids, qty = qtys), id))
+  {
+    rows.emplace_back(id(row), price(row), qty(row));
+  }
+  REQUIRE(rows == (std::vector<std::tuple<int, double, int>>{
+                      { 2, 2, 1 }, { 2, 2, 2 }, { 2, 3, 1 }, { 2, 3, 2 }, { 5, 5, 4 }, { 9, 7, 7 }, { 9, 8, 7 } }));
+
+  // the same rows as hash_join, in the same order when keys are sorted
+  std::vector<std::tuple<int, double, int>> hashed;
+  for (auto row : rekt::hash_join(rekt::zip(id = left_ids, price = prices), rekt::zip(id = right_ids, qty = qtys), id))
+  {
+    hashed.emplace_back(id(row), price(row), qty(row));
+  }
+  REQUIRE(rows == hashed);
+
+  // galloping over long unmatched stretches
+  std::vector<int> evens, sparse{ -1, 5000, 5001, 20000 };
+  for (int i = 0; i != 10000; i += 2)
+  {
+    evens.push_back(i);
+  }
+  std::vector<int> matched;
+  for (auto row : rekt::merge_join(rekt::zip(id = evens), rekt::zip(id = sparse), id))
+  {
+    matched.push_back(id(row));
+  }
+  REQUIRE(matched == std::vector<int>{ 5000 });
+
+  std::vector<int> none;
+  auto empty = rekt::merge_join(rekt::zip(id = none), rekt::zip(id = sparse), id);
+  REQUIRE(empty.begin() == empty.end());
+}
+
+TEST_CASE("group_by")
+{
+  REKT_SYMBOLS(account, price, qty, total, n, hi, lo);
+  std::vector<std::string> accounts{ "b", "a", "b", "c", "a", "b" };
+  std::vector<double> prices{ 1, 2, 3, 4, 5, -6 };
+  std::list<int> qtys{ 1, 2, 3, 4, 5, 6 };
+
+  auto rollup = rekt::group_by(rekt::zip(account = accounts, price = prices, qty = qtys), account)
+                    .aggregate(total = rekt::sum(price), n = rekt::count(), hi = rekt::max(price), lo = rekt::min(qty));
+
+  static_assert(std::is_same<decltype(rollup),
+                             rekt::columns<rekt::record<rekt::field<struct account, std::string>,
+                                                        rekt::field<struct total, double>,
+                                                        rekt::field<struct n, std::size_t>,
+                                                        rekt::field<struct hi, double>,
+                                                        rekt::field<struct lo, int>>>>(),
+                "the schema is the key followed by the aggregates");
+
+  // in order of first appearance
+  REQUIRE(account(rollup) == (std::vector<std::string>{ "b", "a", "c" }));
+  REQUIRE(total(rollup) == (std::vector<double>{ -2, 7, 4 }));
+  REQUIRE(n(rollup) == (std::vector<std::size_t>{ 3, 2, 1 }));
+  REQUIRE(hi(rollup) == (std::vector<double>{ 3, 5, 4 }));
+  REQUIRE(lo(rollup) == (std::vector<int>{ 1, 2, 4 }));
+
+  // bool columns have unsigned char extrema: any and all
+  std::vector<bool> flags{ true, false, false, true, false, true };
+  auto any_all = rekt::group_by(rekt::zip(account = accounts, qty = flags), account)
+                     .aggregate(hi = rekt::max(qty), lo = rekt::min(qty));
+  static_assert(std::is_same<decltype(hi(any_all)), std::vector<unsigned char> &>(), "not std::vector<bool>");
+  REQUIRE(hi(any_all) == (std::vector<unsigned char>{ 1, 0, 1 }));
+  REQUIRE(lo(any_all) == (std::vector<unsigned char>{ 0, 0, 1 }));
+
+  // more rows than a batch, more groups than the table's initial capacity
+  rekt::columns<rekt::record<rekt::field<struct account, int>, rekt::field<struct qty, int>>> many;
+  for (int i = 0; i != 10000; ++i)
+  {
+    many.push_back(rekt::make_record(account = i % 1000, qty = 1 << 30));
+  }
+  auto sums = rekt::group_by(many, account).aggregate(total = rekt::sum(qty));
+  static_assert(std::is_same<decltype(total(sums)), std::vector<long long> &>(), "integers are summed in 64 bits");
+  REQUIRE(sums.size() == 1000);
+  REQUIRE(std::all_of(total(sums).begin(), total(sums).end(), [](long long t) { return t == 10LL << 30; }));
+  REQUIRE(account(sums)[999] == 999);
+}
+
+TEST_CASE("sort_by several keys")
+{
+  REKT_SYMBOLS(account, timestamp, amount, memo);
+  std::vector<short> accounts{ 2, 1, 2, 1, 3, 2 };
+  std::vector<int> timestamps{ 10, 20, 30, 10, 50, 30 };
+  std::vector<double> amounts{ 1, 2, 3, 4, 5, 6 };
+  std::vector<std::string> memos{ "a", "b", "c", "d", "e", "f" };
+
+  // packed into one word: 16 + 32 bits
+  rekt::sort_by(rekt::zip(account = accounts, timestamp = timestamps, amount = amounts), account, -timestamp);
+  REQUIRE(accounts == (std::vector<short>{ 1, 1, 2, 2, 2, 3 }));
+  REQUIRE(timestamps == (std::vector<int>{ 20, 10, 30, 30, 10, 50 }));
+  // stable among equal keys
+  REQUIRE(amounts == (std::vector<double>{ 2, 4, 3, 6, 1, 5 }));
+
+  // too wide to pack (and strings can't be radix sorted): a fused comparator
+  rekt::sort_by(rekt::zip(memo = memos, account = accounts, timestamp = timestamps, amount = amounts), -account, timestamp, -memo);
+  REQUIRE(accounts == (std::vector<short>{ 3, 2, 2, 2, 1, 1 }));
+  REQUIRE(timestamps == (std::vector<int>{ 50, 10, 30, 30, 10, 20 }));
+  REQUIRE(memos == (std::vector<std::string>{ "f", "e", "d", "c", "b", "a" }));
+
+  // descending floating point and signed keys
+  std::vector<double> values{ -1.5, 2.0, -0.0, 3.25, -7.0 };
+  std::vector<std::int64_t> signed_keys{ -1, 5, 0, -9, 5 };
+  rekt::sort_by(rekt::zip(amount = values), -amount);
+  REQUIRE(values == (std::vector<double>{ 3.25, 2.0, -0.0, -1.5, -7.0 }));
+  rekt::sort_by(rekt::zip(timestamp = signed_keys, amount = values), -timestamp);
+  REQUIRE(signed_keys == (std::vector<std::int64_t>{ 5, 5, 0, -1, -9 }));
+  REQUIRE(values == (std::vector<double>{ 2.0, -7.0, -0.0, 3.25, -1.5 }));
+}
+
+TEST_CASE("top_k")
+{
+  REKT_SYMBOLS(id, score, team);
+  std::vector<int> ids{ 0, 1, 2, 3, 4, 5, 6, 7 };
+  std::vector<double> scores{ 0.5, 0.9, 0.1, 0.9, 0.7, 0.3, 0.9, 0.2 };
+  std::vector<std::string> teams{ "a", "b", "a", "c", "b", "a", "c", "b" };
+  auto candidates = rekt::zip(id = ids, score = scores, team = teams);
+
+  // highest first; ties keep their order, as with sort_by
+  auto best = rekt::top_k(candidates, 3, -score);
+  REQUIRE(best.size() == 3);
+  REQUIRE(id(best) == (std::vector<int>{ 1, 3, 6 }));
+  REQUIRE(team(best) == (std::vector<std::string>{ "b", "c", "c" }));
+
+  auto worst = rekt::top_k(candidates, 2, score);
+  REQUIRE(id(worst) == (std::vector<int>{ 2, 7 }));
+
+  // the range itself is untouched
+  REQUIRE(ids == (std::vector<int>{ 0, 1, 2, 3, 4, 5, 6, 7 }));
+
+  auto by_team = rekt::top_k(candidates, 4, team, -score);
+  REQUIRE(id(by_team) == (std::vector<int>{ 0, 5, 2, 1 }));
+
+  REQUIRE(rekt::top_k(candidates, 100, score).size() == ids.size());
+  REQUIRE(rekt::top_k(candidates, 0, score).size() == 0);
+
+  // matches sorting every row then taking the first k
+  std::vector<int> many(1000);
+  for (std::size_t i = 0; i != many.size(); ++i)
+  {
+    many[i] = static_cast<int>((i * 7919) % 101);
+  }
+  auto expected = rekt::top_k_permutation(rekt::zip(score = many).begin(), many.size(), many.size(), -score);
+  expected.resize(10);
+  REQUIRE(rekt::top_k_permutation(rekt::zip(score = many).begin(), many.size(), 10, -score) == expected);
+  auto sorted = rekt::sort_permutation(rekt::zip(score = many).begin(), many.size(), -score);
+  sorted.resize(10);
+  REQUIRE(sorted == expected);
+}
+
+TEST_CASE("distinct")
+{
+  REKT_SYMBOLS(name, city, age);
+  std::vector<std::string> names{ "ann", "bob", "cat", "dan", "eve", "fay" };
+  std::vector<std::string> cities{ "nyc", "sf", "nyc", "sf", "la", "nyc" };
+  std::vector<int> ages{ 30, 40, 30, 41, 30, 31 };
+  auto people = rekt::zip(name = names, city = cities, age = ages);
+
+  REQUIRE(rekt::hash_fields(*people.begin(), city, age) == rekt::hash_fields(rekt::make_record(age = 30, city = "nyc"s), city, age));
+  REQUIRE(rekt::hash_fields(*people.begin(), city, age) != rekt::hash_fields(*people.begin(), age, city));
+
+  // the first row of each combination, in order
+  auto firsts = rekt::distinct(people, city, age);
+  REQUIRE(std::vector<std::size_t>(firsts.begin(), firsts.end()) == (std::vector<std::size_t>{ 0, 1, 3, 4, 5 }));
+  auto by_city = rekt::materialize(people, rekt::distinct(people, city), name);
+  REQUIRE(name(by_city) == (std::vector<std::string>{ "ann", "bob", "eve" }));
+  REQUIRE(rekt::distinct(people, age).size() == 4);
+  REQUIRE(rekt::distinct(rekt::zip(age = std::vector<int>{}), age).size() == 0);
+
+  // many rows, few combinations
+  std::vector<int> as(10000), bs(10000);
+  for (std::size_t i = 0; i != as.size(); ++i)
+  {
+    as[i] = static_cast<int>(i % 7);
+    bs[i] = static_cast<int>(i % 11);
+  }
+  auto pairs = rekt::distinct(rekt::zip(city = as, age = bs), city, age);
+  REQUIRE(pairs.size() == 77);
+  REQUIRE(*std::max_element(pairs.begin(), pairs.end()) == 76);
+}
+
+TEST_CASE("record comparison and hashing")
+{
+  REKT_SYMBOLS(user, day, note);
+  using visit = rekt::record<rekt::field<struct user, int>, rekt::field<struct day, int>>;
+  visit a{ 1, 2 }, b{ 1, 3 }, c{ 2, 0 };
+
+  REQUIRE((a == visit{ 1, 2 }));
+  REQUIRE(a != b);
+  REQUIRE(a < b);
+  REQUIRE(b < c);
+  REQUIRE(c > a);
+  REQUIRE(a <= a);
+  REQUIRE(c >= b);
+  REQUIRE_FALSE(a < a);
+
+  // records with the same symbols compare whatever their field order,
+  // and rows of a zip::range compare with records
+  REQUIRE((a == rekt::make_record(day = 2, user = 1)));
+  // < is lexicographic in the left record's field order
+  REQUIRE((rekt::make_record(day = 2, user = 1) > c));
+  REQUIRE((a < c));
+  std::vector<int> users{ 1, 2 }, days{ 2, 0 };
+  auto rows = rekt::zip(user = users, day = days);
+  REQUIRE(*rows.begin() == a);
+  REQUIRE(*rows.begin() < *(rows.begin() + 1));
+  std::vector<visit> sorted{ c, b, a };
+  std::sort(sorted.begin(), sorted.end());
+  REQUIRE(sorted == (std::vector<visit>{ a, b, c }));
+
+  // integers without padding are hashed as bytes
+  STATIC_REQUIRE(rekt::integer_c<bool, rekt::hashes_as_bytes(rekt::type_c<visit>)>);
+  using tagged = rekt::record<rekt::field<struct user, int>, rekt::field<struct note, std::string>>;
+  STATIC_REQUIRE(rekt::integer_c<bool, !rekt::hashes_as_bytes(rekt::type_c<tagged>)>);
+  REQUIRE((rekt::hash{}(a) == rekt::hash{}(visit{ 1, 2 })));
+  REQUIRE(rekt::hash{}(a) != rekt::hash{}(b));
+  REQUIRE((rekt::hash{}(tagged{ 1, "x" }) == rekt::hash_fields(tagged{ 1, "x" }, user, note)));
+
+  std::unordered_map<visit, int> counts;
+  ++counts[a];
+  ++counts[visit{ 1, 2 }];
+  ++counts[b];
+  REQUIRE(counts.size() == 2);
+  REQUIRE(counts[a] == 2);
+  std::unordered_map<tagged, int, rekt::hash> notes{ { tagged{ 1, "x" }, 1 }, { tagged{ 1, "y" }, 2 } };
+  REQUIRE((notes.at(tagged{ 1, "y" }) == 2));
+}
+
+TEST_CASE("packed_record")
+{
+  REKT_SYMBOLS(flag, id, ok, x);
+  auto plain = rekt::make_record(flag = true, id = 1ull, ok = false, x = 1.0);
+  auto packed = rekt::make_packed_record(flag = true, id = 1ull, ok = false, x = 2.0);
+  REQUIRE(sizeof(plain) == 32);
+  REQUIRE(sizeof(packed) == 24);
+
+  // storage order is 8 byte fields, then bools, each in declaration order
+  using layout = decltype(packed)::order;
+  STATIC_REQUIRE(std::is_same<layout, rekt::index_sequence<1, 3, 0, 2>>());
+
+  REQUIRE(flag(packed));
+  REQUIRE(id(packed) == 1);
+  REQUIRE_FALSE(ok(packed));
+  x(packed) = 1.0;
+  REQUIRE(x(packed) == 1.0);
+
+  // declaration order wherever order is visible
+  rekt::packed_record<rekt::field<struct x, double>, rekt::field<struct flag, bool>, rekt::field<struct id, int>> p{ 2.5, true, 7 };
+  REQUIRE(x(p) == 2.5);
+  REQUIRE(id(p) == 7);
+  auto fields = rekt::get(rekt::field_enum, p);
+  REQUIRE(x(fields) == 0);
+  REQUIRE(flag(fields) == 1);
+  REQUIRE(id(fields) == 2);
+  auto doubled = rekt::map(p, [](auto const &, auto const &v) { return v + v; });
+  REQUIRE(id(doubled) == 14);
+
+  using pair = rekt::packed_record<rekt::field<struct flag, bool>, rekt::field<struct id, int>>;
+  REQUIRE((pair{ false, 9 } < pair{ true, 1 }));
+  REQUIRE((pair{ true, 1 } == rekt::make_record(id = 1, flag = true)));
+  REQUIRE((pair{ true, 1 } >= rekt::make_record(flag = true, id = 1)));
+
+  std::unordered_map<pair, int> counts;
+  ++counts[pair{ true, 1 }];
+  ++counts[pair{ true, 1 }];
+  ++counts[pair{ false, 1 }];
+  REQUIRE(counts.size() == 2);
+  REQUIRE((counts[pair{ true, 1 }] == 2));
+  REQUIRE(std::hash<pair>{}(pair{ false, 9 }) == rekt::hash{}(pair{ false, 9 }));
+}
+
+TEST_CASE("bit_packed_record")
+{
+  REKT_SYMBOLS(beta, dark_mode, tier, name, wide);
+  rekt::bits<3> three_bits{ 13 };
+  REQUIRE(three_bits == 5);
+  STATIC_REQUIRE(rekt::integer_c<bool, sizeof(rekt::bits<12>) == 2>);
+
+  auto flags = rekt::make_bit_packed_record(beta = true, dark_mode = false, tier = rekt::bits<3>{ 5 }, name = "x"s);
+  REQUIRE(flags.words().size() == 1);
+  REQUIRE(beta(flags));
+  REQUIRE_FALSE(dark_mode(flags));
+  REQUIRE(tier(flags) == 5);
+  REQUIRE(name(flags) == "x");
+
+  beta(flags) = false;
+  dark_mode(flags) = true;
+  tier(flags) = 7;
+  name(flags) += "y";
+  REQUIRE_FALSE(beta(flags));
+  REQUIRE(dark_mode(flags));
+  REQUIRE(tier(flags) == 7);
+  REQUIRE(name(flags) == "xy");
+  REQUIRE(flags.words()[0] == 0x1E);
+
+  // proxies assign values, like references
+  beta(flags) = dark_mode(flags);
+  REQUIRE(beta(flags));
+  REQUIRE(beta(flags) == get(beta, static_cast<decltype(flags) const &>(flags)));
+
+  auto copy = flags;
+  REQUIRE(copy == flags);
+  REQUIRE(flags.words()[0] == 0x1F);
+  dark_mode(copy) = false;
+  REQUIRE(copy != flags);
+
+  // fields don't straddle words
+  rekt::bit_packed_record<rekt::field<struct tier, rekt::bits<40>>, rekt::field<struct wide, rekt::bits<40>>, rekt::field<struct beta, bool>> big{
+    rekt::bits<40>::mask, 3, true
+  };
+  REQUIRE(big.words().size() == 2);
+  REQUIRE(big.words()[0] == rekt::bits<40>::mask);
+  REQUIRE(wide(big) == 3);
+  REQUIRE(beta(big));
+  auto fields = rekt::get(rekt::field_enum, big);
+  REQUIRE(wide(fields) == 1);
+  auto halves = rekt::map(big, [](auto const &, auto const &v) { return v / 2; });
+  REQUIRE(wide(halves) == 1);
+
+  // thirty flags take one word
+  using feature_flags = rekt::bit_packed_record<
+      rekt::field<struct f0, bool>, rekt::field<struct f1, bool>, rekt::field<struct f2, bool>, rekt::field<struct f3, bool>,
+      rekt::field<struct f4, bool>, rekt::field<struct f5, bool>, rekt::field<struct f6, bool>, rekt::field<struct f7, bool>,
+      rekt::field<struct f8, bool>, rekt::field<struct f9, bool>, rekt::field<struct f10, bool>, rekt::field<struct f11, bool>,
+      rekt::field<struct f12, bool>, rekt::field<struct f13, bool>, rekt::field<struct f14, bool>, rekt::field<struct f15, bool>,
+      rekt::field<struct f16, bool>, rekt::field<struct f17, bool>, rekt::field<struct f18, bool>, rekt::field<struct f19, bool>,
+      rekt::field<struct f20, bool>, rekt::field<struct f21, bool>, rekt::field<struct f22, bool>, rekt::field<struct f23, bool>,
+      rekt::field<struct f24, bool>, rekt::field<struct f25, bool>, rekt::field<struct f26, bool>, rekt::field<struct f27, bool>,
+      rekt::field<struct f28, bool>, rekt::field<struct f29, bool>>;
+  STATIC_REQUIRE(rekt::integer_c<bool, sizeof(feature_flags) == 8>);
+}
+
+TEST_CASE("trivially copyable records")
+{
+  REKT_SYMBOLS(id, price, qty);
+  using trade = rekt::record<rekt::field<struct id, long>, rekt::field<struct price, double>, rekt::field<struct qty, int>>;
+  STATIC_REQUIRE(rekt::integer_c<bool, std::is_trivially_copyable<trade>::value>);
+  STATIC_REQUIRE(rekt::integer_c<bool, std::is_trivially_copy_assignable<trade>::value>);
+  STATIC_REQUIRE(rekt::integer_c<bool, !std::is_trivially_copyable<rekt::record<rekt::field<struct id, std::string>>>::value>);
+
+  // a buffer of raw bytes, as a shared memory segment would be
+  alignas(trade) unsigned char segment[4 * sizeof(trade)];
+  trade trades[] = { { 1, 1.5, 3 }, { 2, 2.5, 4 }, { 3, 3.5, 5 }, { 4, 4.5, 6 } };
+  std::memcpy(segment, trades, sizeof(trades));
+  auto mapped = reinterpret_cast<trade const *>(segment);
+  REQUIRE(mapped[2] == trades[2]);
+  REQUIRE(price(mapped[3]) == 4.5);
+
+  trade t;
+  t = mapped[1];
+  REQUIRE(id(t) == 2);
+  // even non-const lvalues take the trivial (noexcept) copy assignment,
+  // rather than the field by field template operator=
+  STATIC_REQUIRE(rekt::integer_c<bool, noexcept(t = trades[2])>);
+  STATIC_REQUIRE(rekt::integer_c<bool, noexcept(t = std::move(trades[2]))>);
+  t = trades[2];
+  REQUIRE(t == trades[2]);
+  rekt::assign_fields(t, trades[0], rekt::symbol_set<struct qty, struct price, struct id>{});
+  REQUIRE(t == trades[0]);
+  rekt::assign_fields(t, trades[3], rekt::symbol_set<struct qty>{});
+  REQUIRE(qty(t) == 6);
+  REQUIRE(id(t) == 1);
+
+  // references still assign through, std::tie style
+  long i;
+  int q;
+  rekt::record<rekt::field<struct id, long &>, rekt::field<struct qty, int &>>{ i, q } = mapped[3];
+  REQUIRE(i == 4);
+  REQUIRE(q == 6);
+
+  rekt::columns<trade> cols;
+  cols.append(std::begin(trades), std::end(trades));
+  rekt::columns<trade> copy;
+  copy.push_back(trades[0]);
+  copy.append(cols.begin() + 1, cols.end());
+  REQUIRE(copy.size() == 4);
+  REQUIRE(qty(copy) == qty(cols));
+  REQUIRE(price(copy)[3] == 4.5);
+
+  // a columns' own records can be appended to it, columnwise or one by one
+  cols.append(cols.begin(), cols.end());
+  REQUIRE(cols.size() == 8);
+  REQUIRE(std::equal(qty(cols).begin(), qty(cols).begin() + 4, qty(cols).begin() + 4));
+  cols.append(std::make_reverse_iterator(cols.end()), std::make_reverse_iterator(cols.begin() + 4));
+  REQUIRE(cols.size() == 12);
+  REQUIRE(std::equal(qty(cols).begin(), qty(cols).begin() + 4, qty(cols).rbegin()));
+
+  rekt::columns<rekt::record<rekt::field<struct id, bool>>> flags;
+  flags.push_back(rekt::make_record(id = true));
+  flags.push_back(rekt::make_record(id = false));
+  flags.append(flags.begin(), flags.end());
+  REQUIRE(id(flags) == (std::vector<bool>{ true, false, true, false }));
+}
+
+TEST_CASE("split_record")
+{
+  REKT_SYMBOLS(user, expiry, user_agent, audit);
+  using session = rekt::split_record<rekt::record<rekt::field<struct user, int>, rekt::field<struct expiry, long>>,
+                                     rekt::record<rekt::field<struct user_agent, std::string>, rekt::field<struct audit, std::string>>>;
+  STATIC_REQUIRE(rekt::integer_c<bool, sizeof(session) == sizeof(session::hot_type) + sizeof(void *)>);
+
+  session s{ { 7, 3600 }, { "curl"s, ""s } };
+  REQUIRE(user(s) == 7);
+  REQUIRE(user_agent(s) == "curl");
+  audit(s) += "logged in";
+  expiry(s) = 60;
+  REQUIRE(audit(s.cold()) == "logged in");
+  REQUIRE(expiry(s.hot()) == 60);
+  REQUIRE(rekt::get(user_agent, static_cast<session const &>(s)) == "curl");
+
+  auto copy = s;
+  REQUIRE(copy == s);
+  audit(copy) = "";
+  REQUIRE(copy != s);
+  copy = s;
+  REQUIRE(audit(copy) == "logged in");
+  REQUIRE(&audit(copy) != &audit(s));
+
+  auto moved = std::move(copy);
+  REQUIRE(moved == s);
+  copy = moved;
+  REQUIRE(copy == s);
+
+  auto made = rekt::make_split_record(rekt::make_record(user = 8), rekt::make_record(user_agent = "wget"s));
+  REQUIRE(user_agent(made) == "wget");
+  auto fields = rekt::get(rekt::field_enum, s);
+  REQUIRE(user_agent(fields) == 2);
+  auto lengths = rekt::map(s, [](auto const &, auto const &v) { return sizeof(v); });
+  REQUIRE(audit(lengths) == sizeof(std::string));
+
+  rekt::columns<session> sessions;
+  sessions.push_back(s);
+  sessions.push_back(std::move(moved));
+  REQUIRE(sessions.size() == 2);
+  REQUIRE(user(sessions)[1] == 7);
+  REQUIRE(audit(sessions)[1] == "logged in");
+}
+
+struct arena
+{
+  alignas(std::max_align_t) char bytes[1 << 12];
+  std::size_t used = 0;
+};
+
+///
+/// a bump allocator with no default constructor, which frees nothing
+template <typename T>
+struct arena_allocator
+{
+  using value_type = T;
+
+  explicit arena_allocator(arena &a)
+      : pool{ &a }
+  {
+  }
+
+  template <typename U>
+  arena_allocator(arena_allocator<U> const &other)
+      : pool{ other.pool }
+  {
+  }
+
+  T *allocate(std::size_t n)
+  {
+    pool->used = (pool->used + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t);
+    if (pool->used + n * sizeof(T) > sizeof(pool->bytes))
+    {
+      throw std::bad_alloc{};
+    }
+    auto p = reinterpret_cast<T *>(pool->bytes + pool->used);
+    pool->used += n * sizeof(T);
+    return p;
+  }
+
+  void deallocate(T *, std::size_t)
+  {
+  }
+
+  arena *pool;
+};
+
+template <typename T, typename U>
+bool operator==(arena_allocator<T> const &l, arena_allocator<U> const &r)
+{
+  return l.pool == r.pool;
+}
+
+template <typename T, typename U>
+bool operator!=(arena_allocator<T> const &l, arena_allocator<U> const &r)
+{
+  return l.pool != r.pool;
+}
+
+TEST_CASE("allocator-aware records")
+{
+  REKT_SYMBOLS(name, age, friends);
+  using arena_string = std::basic_string<char, std::char_traits<char>, arena_allocator<char>>;
+  using person = rekt::record<rekt::field<struct name, arena_string>, rekt::field<struct age, int>,
+                              rekt::field<struct friends, std::vector<int, arena_allocator<int>>>>;
+  arena request;
+  arena_allocator<char> alloc{ request };
+
+  person p{ std::allocator_arg, alloc, "a name too long for the small string buffer", 30, std::initializer_list<int>{ 1, 2, 3 } };
+  REQUIRE(name(p) == "a name too long for the small string buffer");
+  REQUIRE(age(p) == 30);
+  REQUIRE(friends(p).size() == 3);
+  REQUIRE(name(p).get_allocator() == alloc);
+  REQUIRE(friends(p).get_allocator() == alloc);
+  REQUIRE(request.used >= name(p).size() + 3 * sizeof(int));
+
+  person empty{ std::allocator_arg, alloc };
+  REQUIRE(name(empty).empty());
+  REQUIRE(friends(empty).get_allocator() == alloc);
+
+  // values are copied into the arena the record is made with
+  arena other;
+  auto used = request.used;
+  auto copy = rekt::make_record(std::allocator_arg, arena_allocator<char>{ other }, name = name(p), age = 31, friends = friends(p));
+  REQUIRE(name(copy) == name(p));
+  REQUIRE(name(copy).get_allocator().pool == &other);
+  REQUIRE(friends(copy).get_allocator().pool == &other);
+  REQUIRE(request.used == used);
+  REQUIRE(other.used != 0);
+
+  // values which don't use an allocator ignore it
+  auto plain = rekt::make_record(std::allocator_arg, alloc, name = "x"s, age = 1);
+  REQUIRE(name(plain) == "x");
+
+  rekt::columns<person, arena_allocator<char>> people{ alloc };
+  people.push_back(p);
+  people.push_back(copy);
+  REQUIRE(people.size() == 2);
+  REQUIRE(age(people).get_allocator() == alloc);
+  REQUIRE(people.get_allocator() == alloc);
+  REQUIRE(age(people[1]) == 31);
+}
+
+TEST_CASE("external_sort")
+{
+  REKT_SYMBOLS(account, amount);
+  std::size_t const n = 1000;
+  std::vector<int> accounts(n), expected_accounts;
+  std::vector<double> amounts(n), expected_amounts;
+  for (std::size_t i = 0; i != n; ++i)
+  {
+    accounts[i] = static_cast<int>((i * 7919) % 97);
+    amounts[i] = static_cast<double>(i);
+  }
+  expected_accounts = accounts;
+  expected_amounts = amounts;
+  rekt::sort_by(rekt::zip(account = expected_accounts, amount = expected_amounts), account);
+
+  char const *tmp = std::getenv("TMPDIR");
+  std::string tmpdir = std::string(tmp != nullptr ? tmp : "/tmp") + "/rekt-tests-XXXXXX";
+  REQUIRE(mkdtemp(&tmpdir[0]) != nullptr);
+
+  // a budget of a few rows forces dozens of runs, merged in pairs
+  rekt::external_sort(rekt::zip(account = accounts, amount = amounts), account, tmpdir, 1000);
+  REQUIRE(accounts == expected_accounts);
+  REQUIRE(amounts == expected_amounts);
+
+  // enough runs to merge in two passes, with blocks of many rows
+  std::size_t const many = 200000;
+  std::vector<int> many_accounts(many), expected_many;
+  std::vector<double> many_amounts(many);
+  for (std::size_t i = 0; i != many; ++i)
+  {
+    many_accounts[i] = static_cast<int>((i * 7919) % 1009);
+    many_amounts[i] = static_cast<double>(i);
+  }
+  expected_many = many_accounts;
+  std::stable_sort(expected_many.begin(), expected_many.end());
+  rekt::external_sort(rekt::zip(account = many_accounts, amount = many_amounts), account, tmpdir, 200000);
+  REQUIRE(many_accounts == expected_many);
+  bool stable = true;
+  for (std::size_t i = 1; i != many; ++i)
+  {
+    stable = stable && (many_accounts[i - 1] != many_accounts[i] || many_amounts[i - 1] < many_amounts[i]);
+  }
+  REQUIRE(stable);
+
+  // every temporary file was removed
+  REQUIRE(rmdir(tmpdir.c_str()) == 0);
+
+  // small ranges are sorted in memory, without touching tmpdir
+  std::vector<int> few{ 3, 1, 2 };
+  rekt::external_sort(rekt::zip(account = few), account, "no such directory");
+  REQUIRE(few == (std::vector<int>{ 1, 2, 3 }));
+
+  std::reverse(accounts.begin(), accounts.end());
+  REQUIRE_THROWS_AS(rekt::external_sort(rekt::zip(account = accounts), account, "no such directory", 64), std::runtime_error const &);
+}
+
+TEST_CASE("parallel")
+{
+  REKT_SYMBOLS(price, qty, total);
+  std::size_t const n = 100000;
+  std::vector<double> prices(n), totals(n);
+  std::vector<int> qtys(n);
+  for (std::size_t i = 0; i != n; ++i)
+  {
+    prices[i] = 0.5 * static_cast<double>(i % 7);
+    qtys[i] = static_cast<int>(i % 5);
+  }
+
+  rekt::parallel::thread_pool pool(3);
+  REQUIRE(pool.size() == 3);
+  REQUIRE_THROWS_AS(rekt::parallel::thread_pool(0), std::invalid_argument const &);
+
+  SECTION("for_each")
+  {
+    rekt::parallel::for_each(pool, rekt::zip(price = prices, qty = qtys, total = totals), [&](auto r) {
+      total(r) = price(r) * qty(r);
+    }, 1000);
+    bool all_equal = true;
+    for (std::size_t i = 0; i != n; ++i)
+    {
+      all_equal = all_equal && totals[i] == prices[i] * qtys[i];
+    }
+    REQUIRE(all_equal);
+  }
+
+  SECTION("transform")
+  {
+    rekt::parallel::transform(rekt::zip(price = prices, qty = qtys), totals.begin(), [&](auto r) {
+      return price(r) * qty(r);
+    });
+    bool all_equal = true;
+    for (std::size_t i = 0; i != n; ++i)
+    {
+      all_equal = all_equal && totals[i] == prices[i] * qtys[i];
+    }
+    REQUIRE(all_equal);
+  }
+
+  SECTION("reduce")
+  {
+    auto sum = rekt::parallel::reduce(pool, rekt::zip(price = prices, qty = qtys), 0.0, std::plus<double>{}, [&](auto r) {
+      return price(r) * qty(r);
+    }, 777);
+    double expected = 0;
+    for (std::size_t i = 0; i != n; ++i)
+    {
+      expected += prices[i] * qtys[i];
+    }
+    REQUIRE(sum == Approx(expected));
+
+    // partial results are combined in order
+    std::vector<std::string> letters{ "a", "b", "c", "d", "e" };
+    auto concatenated = rekt::parallel::reduce(pool, rekt::zip(total = letters), ">"s, std::plus<std::string>{}, [&](auto r) {
+      return total(r);
+    }, 2);
+    REQUIRE(concatenated == ">abcde");
+
+    std::vector<int> none;
+    REQUIRE(rekt::parallel::reduce(pool, rekt::zip(qty = none), 42, std::plus<int>{}, [&](auto r) { return qty(r); }) == 42);
+  }
+
+  SECTION("exceptions")
+  {
+    REQUIRE_THROWS_AS(rekt::parallel::for_each(pool, rekt::zip(qty = qtys), [&](auto r) {
+      if (qty(r) == 4)
+      {
+        throw std::runtime_error("four");
+      }
+    }, 100), std::runtime_error const &);
+  }
+
+  SECTION("nested")
+  {
+    std::atomic<int> count{ 0 };
+    pool.run(4, [&](std::size_t) {
+      pool.run(4, [&](std::size_t) { ++count; });
+    });
+    REQUIRE(count == 16);
+  }
+}
+
+TEST_CASE("simd transform")
+{
+  REKT_SYMBOLS(price, qty, fee, total);
+  std::size_t const n = 103; // not a multiple of any pack width
+  std::vector<double> prices(n), fees(n), totals(n);
+  std::vector<int> qtys(n);
+  for (std::size_t i = 0; i != n; ++i)
+  {
+    prices[i] = 0.25 * static_cast<double>(i);
+    qtys[i] = static_cast<int>(i % 9);
+    fees[i] = 1.5;
+  }
+
+  rekt::simd::transform(rekt::zip(price = prices, qty = qtys, fee = fees), total = totals, [](auto price, auto qty, auto fee) {
+    return price * qty - fee;
+  });
+
+  bool all_equal = true;
+  for (std::size_t i = 0; i != n; ++i)
+  {
+    all_equal = all_equal && totals[i] == prices[i] * qtys[i] - fees[i];
+  }
+  REQUIRE(all_equal);
+
+  SECTION("narrow columns")
+  {
+    std::vector<std::int8_t> small(n, 3);
+    std::vector<float> scaled(n);
+    rekt::simd::transform(rekt::zip(qty = small), total = scaled, [](auto qty) { return qty * qty; });
+    REQUIRE(std::count(scaled.begin(), scaled.end(), 9.F) == static_cast<std::ptrdiff_t>(n));
+
+    // narrow integers are promoted to int, as they would be in a scalar
+    // loop, including the last rows (n isn't a multiple of the lanes)
+    std::vector<std::int8_t> hundreds(19, 100);
+    std::vector<int> squares(19);
+    rekt::simd::transform(rekt::zip(qty = hundreds), total = squares, [](auto qty) {
+      static_assert(std::is_same<decltype(qty), rekt::simd::pack<int>>::value, "int8_t columns are promoted");
+      return qty * qty;
+    });
+    REQUIRE(std::count(squares.begin(), squares.end(), 10000) == 19);
+  }
+
+  SECTION("columns")
+  {
+    rekt::columns<rekt::record<rekt::field<struct price, float>, rekt::field<struct qty, float>>> cols(n);
+    std::fill(price(cols).begin(), price(cols).end(), 2.F);
+    std::fill(qty(cols).begin(), qty(cols).end(), 3.F);
+    rekt::simd::transform(cols, total = totals, [](auto, auto) { return 7.0; });
+    REQUIRE(std::count(totals.begin(), totals.end(), 7.0) == static_cast<std::ptrdiff_t>(n));
+  }
+
+  SECTION("short destination")
+  {
+    std::vector<double> short_totals(n - 1);
+    REQUIRE_THROWS_AS(rekt::simd::transform(rekt::zip(price = prices), total = short_totals, [](auto p) { return p; }),
+                      std::length_error const &);
+  }
+}